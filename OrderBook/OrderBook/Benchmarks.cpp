@@ -0,0 +1,270 @@
+#include "Benchmarks.h"
+#include "OrderBookEngine.h"
+#include "ResultsWriter.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr size_t featuresCount = 11;
+
+// Deterministic row that looks like the one of results.csv
+void GenerateRow(const size_t row, size_t& timeStamp, double& bestBid, double& bestAsk, double* features)
+{
+	timeStamp = 1643673600000000 + row * 1000;
+	bestBid = 38000.0 + static_cast<double>(row % 1000) * 0.5;
+	bestAsk = bestBid + 0.5;
+	for (size_t i = 0; i < featuresCount; ++i) {
+		features[i] = bestBid * (i + 1) / 7.0 + static_cast<double>(row % 97) / 13.0;
+	}
+}
+
+template <typename WriteRows>
+double MeasureRowsPerSecond(const size_t rows, WriteRows writeRows)
+{
+	const auto begin = std::chrono::steady_clock::now();
+	writeRows();
+	const auto end = std::chrono::steady_clock::now();
+	const double seconds = std::chrono::duration<double>(end - begin).count();
+	return rows / seconds;
+}
+
+void WriteRows(ordwriter::ResultsWriter& results, const size_t rows)
+{
+	size_t timeStamp = 0;
+	double bestBid = 0.0, bestAsk = 0.0, features[featuresCount];
+	for (size_t row = 0; row < rows; ++row) {
+		GenerateRow(row, timeStamp, bestBid, bestAsk, features);
+		results.Write(timeStamp);
+		results.WriteSeparator();
+		results.Write(bestBid);
+		results.WriteSeparator();
+		results.Write(bestAsk);
+		for (size_t i = 0; i < featuresCount; ++i) {
+			results.WriteSeparator();
+			results.Write(features[i]);
+		}
+		results.EndRow();
+	}
+	results.Close();
+}
+
+struct Event
+{
+	bool syncShot = false;
+	size_t timeStamp = 0;
+	OrderType side = OrderType::BID;
+	double price = 0.0;
+	double quantity = 0.0;
+};
+
+// Sync shot of 100 levels per side every 10000 events, other events are updates near the touch
+std::vector<Event> GenerateEvents(const size_t count)
+{
+	std::mt19937_64 generator(42);
+	std::uniform_int_distribution<int> levelDistribution(0, 50);
+	std::uniform_int_distribution<int> stepDistribution(0, 3);
+	std::uniform_real_distribution<double> quantityDistribution(0.0, 5.0);
+
+	std::vector<Event> events;
+	events.reserve(count);
+	size_t timeStamp = 1643673600000000;
+	const double midPrice = 38000.0;
+	while (events.size() < count) {
+		if (events.size() % 10000 == 0) {
+			timeStamp += 1000;
+			for (int level = 0; level < 100 && events.size() < count; ++level) {
+				events.push_back({ true, timeStamp, OrderType::BID, midPrice - 0.5 - level * 0.5, 1.0 });
+				events.push_back({ true, timeStamp, OrderType::ASK, midPrice + 0.5 + level * 0.5, 1.0 });
+			}
+			continue;
+		}
+
+		timeStamp += stepDistribution(generator) * 1000;
+		const OrderType side = generator() % 2 ? OrderType::BID : OrderType::ASK;
+		const double distance = 0.5 + levelDistribution(generator) * 0.5;
+		const double price = side == OrderType::BID ? midPrice - distance : midPrice + distance;
+		const double quantity = generator() % 4 ? quantityDistribution(generator) : 0.0;
+		events.push_back({ false, timeStamp, side, price, quantity });
+	}
+	return events;
+}
+
+void PushEvents(const std::vector<Event>& events, ordengine::OrderBookEngine& engine)
+{
+	for (const Event& event : events) {
+		if (event.syncShot) {
+			engine.OnSyncShot(event.timeStamp, event.side, event.price, event.quantity);
+		}
+		else {
+			engine.OnUpdate(event.timeStamp, event.side, event.price, event.quantity);
+		}
+	}
+	engine.Finish();
+}
+
+// Counts records and hashes all their fields in the order of records,
+// so sinks that received the same sequence of records have the same hash
+class CountingSink : public ordengine::RecordSink
+{
+public:
+	void OnRecord(const ordengine::BookRecord& record) override
+	{
+		++records;
+		Hash(record.timeStamp);
+		Hash(std::bit_cast<std::uint64_t>(record.bestBidPrice));
+		Hash(std::bit_cast<std::uint64_t>(record.bestAskPrice));
+		if (record.featureSet) {
+			for (size_t i = 0; i < record.featureSet->size; ++i) {
+				Hash(std::bit_cast<std::uint64_t>(record.features[i]));
+			}
+		}
+	}
+
+	size_t records = 0;
+	std::uint64_t hash = 14695981039346656037ull;
+
+private:
+	// FNV-1a over 64-bit words
+	void Hash(const std::uint64_t value)
+	{
+		hash ^= value;
+		hash *= 1099511628211ull;
+	}
+};
+
+template <typename PushEvents>
+double MeasureNanosecondsPerEvent(const size_t events, PushEvents pushEvents)
+{
+	const auto begin = std::chrono::steady_clock::now();
+	pushEvents();
+	const auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - begin).count() / events;
+}
+
+bool FilesAreEqual(const std::filesystem::path& first, const std::filesystem::path& second)
+{
+	std::ifstream firstFile(first, std::ios::binary), secondFile(second, std::ios::binary);
+	return std::equal(std::istreambuf_iterator<char>(firstFile), std::istreambuf_iterator<char>(),
+	                  std::istreambuf_iterator<char>(secondFile), std::istreambuf_iterator<char>());
+}
+}
+
+void ordbench::BenchmarkResultsOutput(const std::filesystem::path& directory, const size_t rows)
+{
+	const auto streamPath = directory / "benchmark_ofstream.csv";
+	const auto syncPath = directory / "benchmark_writer.csv";
+	const auto asyncPath = directory / "benchmark_writer_async.csv";
+
+	const double streamRate = MeasureRowsPerSecond(rows, [&]() {
+		std::ofstream results(streamPath);
+		size_t timeStamp = 0;
+		double bestBid = 0.0, bestAsk = 0.0, features[featuresCount];
+		for (size_t row = 0; row < rows; ++row) {
+			GenerateRow(row, timeStamp, bestBid, bestAsk, features);
+			results << timeStamp << "," << bestBid << "," << bestAsk;
+			for (size_t i = 0; i < featuresCount; ++i) {
+				results << "," << features[i];
+			}
+			results << std::endl;
+		}
+	});
+
+	const double syncRate = MeasureRowsPerSecond(rows, [&]() {
+		ordwriter::ResultsWriter results(syncPath);
+		WriteRows(results, rows);
+	});
+
+	const double asyncRate = MeasureRowsPerSecond(rows, [&]() {
+		ordwriter::ResultsWriter results(asyncPath, /* asyncFlush = */ true);
+		WriteRows(results, rows);
+	});
+
+	std::cout << "Results output benchmark, " << rows << " rows" << std::endl;
+	std::cout << "std::ofstream with std::endl:    " << static_cast<size_t>(streamRate) << " rows/s" << std::endl;
+	std::cout << "ResultsWriter:                   " << static_cast<size_t>(syncRate) << " rows/s, x"
+	          << syncRate / streamRate << std::endl;
+	std::cout << "ResultsWriter with async flush:  " << static_cast<size_t>(asyncRate) << " rows/s, x"
+	          << asyncRate / streamRate << std::endl;
+	std::cout << "ResultsWriter outputs are identical: "
+	          << (FilesAreEqual(syncPath, asyncPath) ? "yes" : "no") << std::endl;
+
+	std::filesystem::remove(streamPath);
+	std::filesystem::remove(syncPath);
+	std::filesystem::remove(asyncPath);
+}
+
+void ordbench::BenchmarkEngine(const size_t events)
+{
+	const std::vector<Event> generatedEvents = GenerateEvents(events);
+
+	double checksum = 0.0;
+	const double directCost = MeasureNanosecondsPerEvent(events, [&]() {
+		OrderBook orderBook;
+		size_t syncShotTime = 0;
+		for (const Event& event : generatedEvents) {
+			if (event.syncShot && event.timeStamp != syncShotTime) {
+				orderBook.Clear();
+				syncShotTime = event.timeStamp;
+			}
+			orderBook.HandleOrderUpdate(event.price, event.quantity, event.side);
+			checksum += orderBook.GetBestBidPrice();
+		}
+	});
+
+	const auto measureEngine = [&](const ordbkfeatures::FeatureSetInfo* featureSet, CountingSink& sink) {
+		return MeasureNanosecondsPerEvent(events, [&]() {
+			ordengine::OrderBookEngine engine(sink, featureSet);
+			PushEvents(generatedEvents, engine);
+		});
+	};
+
+	CountingSink bboSink, featuresSink;
+	const double engineCost = measureEngine(nullptr, bboSink);
+	const double featuresCost = measureEngine(ordbkfeatures::FindFeatureSet("all"), featuresSink);
+
+	std::cout << "Engine benchmark, " << events << " events, " << bboSink.records << " records" << std::endl;
+	std::cout << "OrderBook directly:              " << directCost << " ns/event" << std::endl;
+	std::cout << "OrderBookEngine:                 " << engineCost << " ns/event, API cost "
+	          << engineCost - directCost << " ns/event" << std::endl;
+	std::cout << "OrderBookEngine with features:   " << featuresCost << " ns/event" << std::endl;
+	// Prevents the compiler from dropping the measured work
+	std::cout << "Checksum: " << checksum << ", records hash: " << (bboSink.hash ^ featuresSink.hash) << std::endl;
+}
+
+void ordbench::BenchmarkFeatureWorkers(const size_t events)
+{
+	const std::vector<Event> generatedEvents = GenerateEvents(events);
+	const ordbkfeatures::FeatureSetInfo* featureSet = ordbkfeatures::FindFeatureSet("all");
+
+	const auto measureWorkers = [&](const size_t workers, CountingSink& sink) {
+		return MeasureNanosecondsPerEvent(events, [&]() {
+			ordengine::OrderBookEngine engine(sink, featureSet, DepthBand(), workers);
+			PushEvents(generatedEvents, engine);
+		});
+	};
+
+	CountingSink inlineSink;
+	const double inlineCost = measureWorkers(0, inlineSink);
+
+	std::cout << "Feature workers benchmark, " << events << " events, " << inlineSink.records << " records, "
+	          << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+	std::cout << "Features on the engine thread:   " << inlineCost << " ns/event" << std::endl;
+
+	const size_t maxWorkers = std::max<size_t>(std::thread::hardware_concurrency(), 2);
+	for (size_t workers = 1; workers <= maxWorkers; workers *= 2) {
+		CountingSink sink;
+		const double cost = measureWorkers(workers, sink);
+		const bool identical = sink.records == inlineSink.records && sink.hash == inlineSink.hash;
+		std::cout << "Features by " << workers << " workers:          " << cost << " ns/event, x" << inlineCost / cost
+		          << ", records are " << (identical ? "identical" : "different") << std::endl;
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <filesystem>
+
+namespace ordbench
+{
+/**
+ * @brief Writes the same synthetic rows (timestamp, best prices and 11 features)
+ * using std::ofstream formatting with std::endl (the previous results output),
+ * ResultsWriter and ResultsWriter with async flush, and prints rows per second for each of them.
+ * Also checks that ResultsWriter output is the same for both flush modes.
+ *
+ * @param directory    Directory where temporary files are created
+ * @param rows         Number of rows to write
+ */
+void BenchmarkResultsOutput(const std::filesystem::path& directory, const size_t rows);
+
+/**
+ * @brief Pushes the same synthetic sync shots and updates held in memory to the order book directly
+ * and through OrderBookEngine without features and with all features,
+ * and prints the cost of an event in nanoseconds for each of them.
+ * The difference between the first two shows the cost of the engine API itself.
+ *
+ * @param events       Number of events to push
+ */
+void BenchmarkEngine(const size_t events);
+
+/**
+ * @brief Pushes the same synthetic sync shots and updates held in memory through OrderBookEngine
+ * with all features calculated on the engine thread and by 1, 2, 4, ... feature workers
+ * up to the number of hardware threads, and prints the cost of an event in nanoseconds for each of them.
+ * Also checks that records passed to the sink are the same for any number of workers.
+ *
+ * @param events       Number of events to push
+ */
+void BenchmarkFeatureWorkers(const size_t events);
+}
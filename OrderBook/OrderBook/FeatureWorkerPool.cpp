@@ -0,0 +1,130 @@
+#include "FeatureWorkerPool.h"
+#include <algorithm>
+
+ordengine::FeatureWorkerPool::FeatureWorkerPool(RecordSink& sink, const ordbkfeatures::FeatureSetInfo& featureSet,
+                                                const size_t workersCount, const size_t maxPendingRecords) :
+	sink_(sink),
+	featureSet_(featureSet),
+	jobs_(std::max<size_t>(maxPendingRecords, 1))
+{
+	for (size_t i = 0; i < workersCount; ++i) {
+		workers_.emplace_back(&FeatureWorkerPool::Work, this);
+	}
+}
+
+ordengine::FeatureWorkerPool::~FeatureWorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	submitCondition_.notify_all();
+	for (std::thread& worker : workers_) {
+		worker.join();
+	}
+}
+
+void ordengine::FeatureWorkerPool::Submit(const size_t timeStamp, const OrderBook& orderBook)
+{
+	if (submittedJobs_ - deliveredJobs_ == jobs_.size()) {
+		DeliverOldest();
+	}
+
+	// The slot is not used by workers until the job is submitted
+	Job& job = jobs_[submittedJobs_ % jobs_.size()];
+	job.timeStamp = timeStamp;
+	job.orderBook.emplace(orderBook);
+
+	bool wakeUp = false;
+	size_t readyJobs = 0;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		job.done = false;
+		++submittedJobs_;
+		wakeUp = idleWorkers_ && submittedJobs_ - takenJobs_ >= wakeUpJobs;
+		while (deliveredJobs_ + readyJobs < submittedJobs_ && jobs_[(deliveredJobs_ + readyJobs) % jobs_.size()].done) {
+			++readyJobs;
+		}
+	}
+	if (wakeUp) {
+		submitCondition_.notify_all();
+	}
+
+	// Ready jobs are not touched by workers anymore
+	for (; readyJobs; --readyJobs) {
+		Deliver(jobs_[deliveredJobs_ % jobs_.size()]);
+	}
+}
+
+void ordengine::FeatureWorkerPool::Drain()
+{
+	while (deliveredJobs_ < submittedJobs_) {
+		DeliverOldest();
+	}
+}
+
+void ordengine::FeatureWorkerPool::Work()
+{
+	Job* calculatedJob = nullptr;
+	while (true)
+	{
+		Job* job = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			if (calculatedJob) {
+				calculatedJob->done = true;
+				if (waitingForDone_) {
+					doneCondition_.notify_one();
+				}
+			}
+
+			if (!stop_ && takenJobs_ == submittedJobs_) {
+				++idleWorkers_;
+				submitCondition_.wait(lock, [this] { return stop_ || takenJobs_ < submittedJobs_; });
+				--idleWorkers_;
+			}
+			if (stop_) {
+				return;
+			}
+			job = &jobs_[takenJobs_++ % jobs_.size()];
+		}
+
+		featureSet_.calculate(*job->orderBook, job->features);
+		calculatedJob = job;
+	}
+}
+
+void ordengine::FeatureWorkerPool::Deliver(Job& job)
+{
+	BookRecord record;
+	record.timeStamp = job.timeStamp;
+	record.bestBidPrice = job.orderBook->GetBestBidPrice();
+	record.bestAskPrice = job.orderBook->GetBestAskPrice();
+	record.featureSet = &featureSet_;
+	record.features = job.features;
+	record.orderBook = &*job.orderBook;
+	record.bandExhausted = job.orderBook->IsBandExhausted();
+	sink_.OnRecord(record);
+
+	// The version is released, so the order book does not copy levels shared with it anymore
+	job.orderBook.reset();
+	++deliveredJobs_;
+}
+
+void ordengine::FeatureWorkerPool::DeliverOldest()
+{
+	Job& job = jobs_[deliveredJobs_ % jobs_.size()];
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		if (!job.done) {
+			// Jobs that are not enough to wake up workers by Submit are calculated now
+			if (idleWorkers_ && takenJobs_ < submittedJobs_) {
+				submitCondition_.notify_all();
+			}
+			waitingForDone_ = true;
+			doneCondition_.wait(lock, [&job] { return job.done; });
+			waitingForDone_ = false;
+		}
+	}
+	Deliver(job);
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include "OrderBookEngine.h"
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace ordengine
+{
+/**
+ * @class FeatureWorkerPool
+ * @brief Calculates features of order book versions by a pool of worker threads.
+ * Versions are submitted by the thread that maintains the order book, which continues
+ * to apply updates while features are calculated. Records are passed to the sink
+ * on the submitting thread in the order of submission, so the sink sees the same sequence
+ * of records as with inline calculation.
+ *
+ * At most maxPendingRecords records are in progress, Submit waits for the oldest record
+ * when the limit is reached, so memory held by versions is bounded.
+ * Idle workers are woken up only when wakeUpJobs jobs are waiting for them or the submitting thread
+ * waits for a record, and the submitting thread is woken up only when it waits, so threads
+ * are not switched for every record.
+ */
+class FeatureWorkerPool
+{
+public:
+	static constexpr size_t defaultMaxPendingRecords = 256;
+	static constexpr size_t wakeUpJobs = 32;
+
+	/**
+	 * @brief Constructor.
+	 * Starts worker threads
+	 *
+	 * @param sink                 Receiver of records
+	 * @param featureSet           Features calculated for every record
+	 * @param workersCount         Number of worker threads
+	 * @param maxPendingRecords    Max number of submitted records that are not passed to the sink yet
+	 */
+	FeatureWorkerPool(RecordSink& sink, const ordbkfeatures::FeatureSetInfo& featureSet, const size_t workersCount,
+	                  const size_t maxPendingRecords = defaultMaxPendingRecords);
+
+	/**
+	 * @brief Destructor.
+	 * Stops worker threads, records that are not passed to the sink yet are dropped
+	 */
+	~FeatureWorkerPool();
+
+	FeatureWorkerPool(const FeatureWorkerPool&) = delete;
+	FeatureWorkerPool& operator=(const FeatureWorkerPool&) = delete;
+
+	/**
+	 * @brief Submits the version of the order book for the timestamp
+	 * and passes records whose features are ready to the sink
+	 *
+	 * @param timeStamp    Timestamp of the record
+	 * @param orderBook    Order book, its copy is submitted
+	 */
+	void Submit(const size_t timeStamp, const OrderBook& orderBook);
+
+	/**
+	 * @brief Waits for all submitted records and passes them to the sink
+	 */
+	void Drain();
+
+private:
+	struct Job
+	{
+		size_t timeStamp = 0;
+		std::optional<OrderBook> orderBook;
+		double features[ordbkfeatures::maxFeatureSetSize] = {};
+		bool done = false;
+	};
+
+	void Work();
+	void Deliver(Job& job);
+	void DeliverOldest();
+
+private:
+	RecordSink& sink_;
+	const ordbkfeatures::FeatureSetInfo& featureSet_;
+
+	// Jobs are submitted, taken by workers and delivered in round robin order
+	std::vector<Job> jobs_;
+	size_t submittedJobs_ = 0;
+	size_t takenJobs_ = 0;
+	size_t deliveredJobs_ = 0;
+	size_t idleWorkers_ = 0;
+	bool waitingForDone_ = false;
+	bool stop_ = false;
+	std::mutex mutex_;
+	std::condition_variable submitCondition_;
+	std::condition_variable doneCondition_;
+	std::vector<std::thread> workers_;
+};
+}
@@ -0,0 +1,234 @@
+#include "FileSequencer.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+bool ordfiles::IsDay(const std::string& day)
+{
+	return day.size() == 8 && std::all_of(day.begin(), day.end(), [](const char c) { return c >= '0' && c <= '9'; });
+}
+
+std::vector<ordfiles::DayFiles> ordfiles::FindDayFiles(const std::filesystem::path& directory,
+                                                       const std::string& instrument,
+                                                       const std::string& firstDay, const std::string& lastDay)
+{
+	const std::string prefix = instrument + "_";
+	const std::string syncShotsSuffix = "_syncshots.csv";
+	const std::string updatesSuffix = "_updates.csv";
+	constexpr size_t dayLength = 8;
+
+	std::vector<DayFiles> days;
+	for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+		const std::string name = entry.path().filename().string();
+		if (name.size() < prefix.size() + dayLength + syncShotsSuffix.size() ||
+			name.compare(0, prefix.size(), prefix) != 0 ||
+			name.compare(name.size() - syncShotsSuffix.size(), syncShotsSuffix.size(), syncShotsSuffix) != 0)
+		{
+			continue;
+		}
+
+		// Days in YYYYMMDD format can be compared as strings
+		const std::string day = name.substr(prefix.size(), dayLength);
+		if (!IsDay(day) || day < firstDay || day > lastDay) {
+			continue;
+		}
+
+		DayFiles dayFiles;
+		dayFiles.day = day;
+		dayFiles.syncShots = entry.path();
+		dayFiles.updates = directory / (name.substr(0, name.size() - syncShotsSuffix.size()) + updatesSuffix);
+		if (!std::filesystem::exists(dayFiles.updates)) {
+			throw std::runtime_error("Updates file is missing: " + dayFiles.updates.string());
+		}
+		days.push_back(std::move(dayFiles));
+	}
+
+	// Several files can start on the same day, the start timestamp follows the day in the name,
+	// so file names of the instrument are sorted by start timestamps
+	std::sort(days.begin(), days.end(), [](const DayFiles& lhs, const DayFiles& rhs)
+	          { return lhs.syncShots.filename() < rhs.syncShots.filename(); });
+	return days;
+}
+
+ordfiles::PrefetchingLineReader::PrefetchingLineReader(std::vector<std::filesystem::path> paths,
+                                                       const bool skipHeaders,
+                                                       const size_t chunkSize, const size_t chunksCount) :
+	paths_(std::move(paths)),
+	skipHeaders_(skipHeaders),
+	chunkSize_(chunkSize),
+	chunks_(chunksCount)
+{
+	for (Chunk& chunk : chunks_) {
+		chunk.data.resize(chunkSize_);
+	}
+	thread_ = std::thread(&PrefetchingLineReader::Prefetch, this);
+}
+
+ordfiles::PrefetchingLineReader::~PrefetchingLineReader()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	condition_.notify_all();
+	thread_.join();
+}
+
+bool ordfiles::PrefetchingLineReader::ReadLine(std::string_view& line)
+{
+	while (true)
+	{
+		if (current_) {
+			const char* data = current_->data.data();
+			while (position_ < current_->size) {
+				// Every chunk ends with the line break, so it is always found
+				const char* begin = data + position_;
+				const char* end = static_cast<const char*>(std::memchr(begin, '\n', current_->size - position_));
+				position_ = end - data + 1;
+
+				size_t length = end - begin;
+				if (length && begin[length - 1] == '\r') {
+					--length;
+				}
+				if (length) {
+					line = std::string_view(begin, length);
+					return true;
+				}
+			}
+			ReleaseChunk();
+		}
+
+		if (!AcquireFilledChunk()) {
+			return false;
+		}
+	}
+}
+
+void ordfiles::PrefetchingLineReader::Prefetch()
+{
+	try {
+		for (const auto& path : paths_) {
+			ReadFile(path);
+		}
+	}
+	catch (...) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		error_ = std::current_exception();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		finished_ = true;
+	}
+	condition_.notify_all();
+}
+
+void ordfiles::PrefetchingLineReader::ReadFile(const std::filesystem::path& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("Could not open file: " + path.string());
+	}
+
+	if (skipHeaders_) {
+		std::string header;
+		std::getline(file, header);
+	}
+
+	carry_.clear();
+	bool fileIsOver = false;
+	while (!fileIsOver)
+	{
+		Chunk* chunk = AcquireFreeChunk();
+		if (!chunk) {
+			return;
+		}
+
+		// The chunk starts with the incomplete line of the previous one
+		if (chunk->data.size() < std::max(carry_.size() + 1, chunkSize_)) {
+			chunk->data.resize(std::max(2 * carry_.size(), chunkSize_));
+		}
+		std::copy(carry_.begin(), carry_.end(), chunk->data.begin());
+		size_t size = carry_.size();
+		carry_.clear();
+
+		while (true)
+		{
+			file.read(chunk->data.data() + size, chunk->data.size() - size);
+			size += static_cast<size_t>(file.gcount());
+			if (!file) {
+				fileIsOver = true;
+				break;
+			}
+
+			// The rest of the last line is moved to the next chunk
+			const auto lastLineEnd = std::find(chunk->data.rbegin() + (chunk->data.size() - size),
+			                                   chunk->data.rend(), '\n');
+			if (lastLineEnd != chunk->data.rend()) {
+				const size_t linesSize = chunk->data.rend() - lastLineEnd;
+				carry_.assign(chunk->data.begin() + linesSize, chunk->data.begin() + size);
+				size = linesSize;
+				break;
+			}
+
+			// The line is longer than the chunk
+			chunk->data.resize(2 * chunk->data.size());
+		}
+
+		// The last line of the file may have no line break
+		if (fileIsOver && size && chunk->data[size - 1] != '\n') {
+			if (size == chunk->data.size()) {
+				chunk->data.resize(size + 1);
+			}
+			chunk->data[size++] = '\n';
+		}
+
+		if (size) {
+			chunk->size = size;
+			PublishChunk();
+		}
+	}
+}
+
+ordfiles::PrefetchingLineReader::Chunk* ordfiles::PrefetchingLineReader::AcquireFreeChunk()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	condition_.wait(lock, [this] { return stop_ || filledChunks_ - consumedChunks_ < chunks_.size(); });
+	return stop_ ? nullptr : &chunks_[filledChunks_ % chunks_.size()];
+}
+
+void ordfiles::PrefetchingLineReader::PublishChunk()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		++filledChunks_;
+	}
+	condition_.notify_all();
+}
+
+bool ordfiles::PrefetchingLineReader::AcquireFilledChunk()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	condition_.wait(lock, [this] { return filledChunks_ > consumedChunks_ || finished_; });
+	if (filledChunks_ > consumedChunks_) {
+		current_ = &chunks_[consumedChunks_ % chunks_.size()];
+		position_ = 0;
+		return true;
+	}
+
+	if (error_) {
+		std::rethrow_exception(error_);
+	}
+	return false;
+}
+
+void ordfiles::PrefetchingLineReader::ReleaseChunk()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		++consumedChunks_;
+		current_ = nullptr;
+	}
+	condition_.notify_all();
+}
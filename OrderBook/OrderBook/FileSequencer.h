@@ -0,0 +1,126 @@
+#pragma once
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace ordfiles
+{
+/**
+ * @struct DayFiles
+ * @brief Sync shots and updates files that start on the same timestamp of one day
+ */
+struct DayFiles
+{
+	// Day in YYYYMMDD format
+	std::string day;
+	std::filesystem::path syncShots;
+	std::filesystem::path updates;
+};
+
+/**
+ * @return             True if the string is a day in YYYYMMDD format, i.e. consists of 8 digits
+ */
+bool IsDay(const std::string& day);
+
+/**
+ * @brief Finds files of the instrument for every day in the range.
+ * Files are expected to be named as <instrument>_<YYYYMMDDhhmmss>_<YYYYMMDDhhmmss>_syncshots.csv
+ * and <instrument>_<YYYYMMDDhhmmss>_<YYYYMMDDhhmmss>_updates.csv, where the first timestamp is the day start.
+ * Days without files and files without a day in YYYYMMDD format are skipped.
+ * If several files start on the same day, they are sorted by their start timestamps.
+ *
+ * @param directory    Directory with files
+ * @param instrument   Instrument prefix of file names, e.g. BTC-PERP_FTX_FUT
+ * @param firstDay     First day of the range in YYYYMMDD format
+ * @param lastDay      Last day of the range in YYYYMMDD format, inclusive
+ * @return             Files sorted by start timestamps
+ */
+std::vector<DayFiles> FindDayFiles(const std::filesystem::path& directory, const std::string& instrument,
+                                   const std::string& firstDay, const std::string& lastDay);
+
+/**
+ * @class PrefetchingLineReader
+ * @brief Reads lines of several files one after another as of one file.
+ * Files are read by the background thread in large chunks to the ring of reusable buffers,
+ * so the next file is opened and read ahead while lines of the current one are being processed.
+ * Every chunk contains only whole lines.
+ */
+class PrefetchingLineReader
+{
+public:
+	static constexpr size_t defaultChunkSize = 1 << 22;
+	static constexpr size_t defaultChunksCount = 4;
+
+	/**
+	 * @brief Constructor.
+	 * Starts reading files in the background thread
+	 *
+	 * @param paths        Files to read in the given order
+	 * @param skipHeaders  If true, the first line of every file is skipped
+	 * @param chunkSize    Size of a chunk in bytes
+	 * @param chunksCount  Max number of chunks read ahead
+	 */
+	PrefetchingLineReader(std::vector<std::filesystem::path> paths, const bool skipHeaders = true,
+	                      const size_t chunkSize = defaultChunkSize, const size_t chunksCount = defaultChunksCount);
+
+	/**
+	 * @brief Destructor.
+	 * Stops the background thread
+	 */
+	~PrefetchingLineReader();
+
+	PrefetchingLineReader(const PrefetchingLineReader&) = delete;
+	PrefetchingLineReader& operator=(const PrefetchingLineReader&) = delete;
+
+	/**
+	 * @brief Returns the next non empty line without the line break.
+	 * Throws std::runtime_error if some file could not be read
+	 *
+	 * @param line         Resulting line, it is valid until the next call
+	 * @return             False if all files are over
+	 */
+	bool ReadLine(std::string_view& line);
+
+private:
+	struct Chunk
+	{
+		std::vector<char> data;
+		size_t size = 0;
+	};
+
+	void Prefetch();
+	void ReadFile(const std::filesystem::path& path);
+	Chunk* AcquireFreeChunk();
+	void PublishChunk();
+	bool AcquireFilledChunk();
+	void ReleaseChunk();
+
+private:
+	const std::vector<std::filesystem::path> paths_;
+	const bool skipHeaders_;
+	const size_t chunkSize_;
+
+	// Chunks are filled and consumed in round robin order
+	std::vector<Chunk> chunks_;
+	size_t filledChunks_ = 0;
+	size_t consumedChunks_ = 0;
+	bool finished_ = false;
+	bool stop_ = false;
+	std::exception_ptr error_;
+	std::mutex mutex_;
+	std::condition_variable condition_;
+	std::thread thread_;
+
+	// Used only by the background thread, the last incomplete line of the previous chunk
+	std::vector<char> carry_;
+
+	// Used only by the reading thread
+	Chunk* current_ = nullptr;
+	size_t position_ = 0;
+};
+}
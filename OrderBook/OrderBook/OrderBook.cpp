@@ -16,6 +16,19 @@ void OrderBook::Clear()
 	askOrders_.Clear();
 }
 
+void OrderBook::SetDepthBand(const DepthBand& depthBand)
+{
+	bidOrders_.SetDepthBand(depthBand);
+	askOrders_.SetDepthBand(depthBand);
+}
+
+DepthBandStatistics OrderBook::GetDepthBandStatistics() const
+{
+	DepthBandStatistics statistics = bidOrders_.GetDepthBandStatistics();
+	statistics += askOrders_.GetDepthBandStatistics();
+	return statistics;
+}
+
 double OrderBook::GetBestBidPrice() const
 {
 	return bidOrders_.GetBestPrice();
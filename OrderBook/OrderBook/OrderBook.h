@@ -7,6 +7,8 @@
  * @brief Implements logic of storage of bid and ask orders.
  * Provides access to orders of both type via GetBidOrders and GetAskOrders methods.
  * Modification of orders is available via Clear and HandleOrderUpdate method.
+ * A copy of the order book is a cheap immutable version: it shares levels with the original
+ * and can be read by another thread while the original is being modified.
  */
 class OrderBook
 {
@@ -27,6 +29,25 @@ public:
 	 */
 	void Clear();
 
+	/**
+	 * @brief Limits tracked levels of both sides to the depth band around the touch.
+	 * Must be called before any order is added
+	 *
+	 * @param depthBand    Band limits applied to each side, default value disables the band
+	 */
+	void SetDepthBand(const DepthBand& depthBand);
+
+	/**
+	 * @return             Depth band counters summed over both sides
+	 */
+	DepthBandStatistics GetDepthBandStatistics() const;
+
+	/**
+	 * @return             True if the band of some side is exhausted, so best prices and features may be wrong
+	 *                     until the next Clear (see Orders::IsBandExhausted)
+	 */
+	bool IsBandExhausted() const { return bidOrders_.IsBandExhausted() || askOrders_.IsBandExhausted(); }
+
 public:
 	/**
 	 * @return             Bid Orders
@@ -0,0 +1,107 @@
+#include "OrderBookEngine.h"
+#include "FeatureWorkerPool.h"
+
+ordengine::OrderBookEngine::OrderBookEngine(RecordSink& sink, const ordbkfeatures::FeatureSetInfo* featureSet,
+                                            const DepthBand& depthBand, const size_t featureWorkers) :
+	sink_(sink),
+	featureSet_(featureSet)
+{
+	orderBook_.SetDepthBand(depthBand);
+	if (featureSet_ && featureWorkers) {
+		featureWorkers_ = std::make_unique<FeatureWorkerPool>(sink_, *featureSet_, featureWorkers);
+	}
+}
+
+ordengine::OrderBookEngine::~OrderBookEngine() = default;
+
+void ordengine::OrderBookEngine::OnSyncShot(const size_t timeStamp, const OrderType side,
+                                            const double price, const double quantity)
+{
+	StartTimestamp(timeStamp);
+
+	// Sync shot with a new timestamp replaces the whole order book
+	if (!hasSyncShot_ || syncShotTime_ != timeStamp) {
+		orderBook_.Clear();
+		hasSyncShot_ = true;
+		syncShotTime_ = timeStamp;
+	}
+
+	orderBook_.HandleOrderUpdate(price, quantity, side);
+}
+
+void ordengine::OrderBookEngine::OnUpdate(const size_t timeStamp, const OrderType side,
+                                          const double price, const double quantity)
+{
+	// Updates before the first sync shot are ignored
+	if (!hasSyncShot_) {
+		return;
+	}
+
+	StartTimestamp(timeStamp);
+	orderBook_.HandleOrderUpdate(price, quantity, side);
+}
+
+void ordengine::OrderBookEngine::OnTrade(const size_t timeStamp, const OrderType side,
+                                         const double price, const double quantity)
+{
+	TradeRecord trade;
+	trade.timeStamp = timeStamp;
+	trade.side = side;
+	trade.price = price;
+	trade.quantity = quantity;
+	sink_.OnTrade(trade);
+}
+
+void ordengine::OrderBookEngine::OnTimestampEnd(const size_t timeStamp)
+{
+	if (hasPendingRecord_ && pendingTime_ <= timeStamp) {
+		LogRecord();
+	}
+	if (featureWorkers_) {
+		featureWorkers_->Drain();
+	}
+}
+
+void ordengine::OrderBookEngine::Finish()
+{
+	if (hasPendingRecord_) {
+		LogRecord();
+	}
+	if (featureWorkers_) {
+		featureWorkers_->Drain();
+	}
+}
+
+void ordengine::OrderBookEngine::StartTimestamp(const size_t timeStamp)
+{
+	// The previous timestamp is over, so its record can be logged
+	if (hasPendingRecord_ && pendingTime_ != timeStamp) {
+		LogRecord();
+	}
+
+	hasPendingRecord_ = true;
+	pendingTime_ = timeStamp;
+}
+
+void ordengine::OrderBookEngine::LogRecord()
+{
+	hasPendingRecord_ = false;
+	if (featureWorkers_) {
+		featureWorkers_->Submit(pendingTime_, orderBook_);
+		return;
+	}
+
+	BookRecord record;
+	record.timeStamp = pendingTime_;
+	record.bestBidPrice = orderBook_.GetBestBidPrice();
+	record.bestAskPrice = orderBook_.GetBestAskPrice();
+	record.orderBook = &orderBook_;
+	record.bandExhausted = orderBook_.IsBandExhausted();
+	if (featureSet_) {
+		featureSet_->calculate(orderBook_, features_);
+		record.featureSet = featureSet_;
+		record.features = features_;
+	}
+
+	sink_.OnRecord(record);
+}
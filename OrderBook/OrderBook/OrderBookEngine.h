@@ -0,0 +1,148 @@
+#pragma once
+#include "OrderBookFeaturesCalculator.h"
+#include <memory>
+
+namespace ordengine
+{
+class FeatureWorkerPool;
+
+/**
+ * @struct BookRecord
+ * @brief State of the order book logged for a timestamp.
+ * Pointers are valid only during the RecordSink::OnRecord call.
+ */
+struct BookRecord
+{
+	size_t timeStamp = 0;
+	// Best prices are -1 if there is no order of this type
+	double bestBidPrice = -1.0;
+	double bestAskPrice = -1.0;
+	// Features of the feature set the engine was created with, null if there is no feature set
+	const ordbkfeatures::FeatureSetInfo* featureSet = nullptr;
+	const double* features = nullptr;
+	const OrderBook* orderBook = nullptr;
+	// The depth band of some side is exhausted, so best prices and features may be wrong until the next sync shot
+	bool bandExhausted = false;
+};
+
+/**
+ * @struct TradeRecord
+ * @brief Trade passed to the engine
+ */
+struct TradeRecord
+{
+	size_t timeStamp = 0;
+	OrderType side = OrderType::BID;
+	double price = 0.0;
+	double quantity = 0.0;
+};
+
+/**
+ * @class RecordSink
+ * @brief Interface of the receiver of records produced by OrderBookEngine.
+ * Records are passed by reference to the engine owned memory, so no allocation is made per record.
+ */
+class RecordSink
+{
+public:
+	virtual ~RecordSink() = default;
+
+	/**
+	 * @brief Called once for every unique timestamp after all its events are applied
+	 */
+	virtual void OnRecord(const BookRecord& record) = 0;
+
+	/**
+	 * @brief Called for every trade passed to the engine, does nothing by default
+	 */
+	virtual void OnTrade(const TradeRecord& /* trade */) {}
+};
+
+/**
+ * @class OrderBookEngine
+ * @brief Maintains the order book from pushed sync shots and updates
+ * and passes its state to the sink for every unique timestamp.
+ *
+ * Events must be pushed in the order of timestamps. If a sync shot and an update have the same timestamp,
+ * the sync shot must be pushed first. Following rules are applied:
+ * All updates pushed before the first sync shot are ignored.
+ * The order book is cleared when a sync shot with a new timestamp is pushed.
+ * If some events have the same timestamp, only the state after the last of them is logged.
+ * The record of a timestamp is passed to the sink when an event with another timestamp is pushed,
+ * or when OnTimestampEnd or Finish is called.
+ *
+ * If feature workers are used, versions of the order book are passed to the pool of worker threads
+ * and features are calculated while next events are applied. Records are passed to the sink
+ * on the thread that pushes events in the order of timestamps, but later than without workers,
+ * so trades can be passed to the sink before records of earlier timestamps.
+ */
+class OrderBookEngine
+{
+public:
+	/**
+	 * @brief Constructor.
+	 *
+	 * @param sink         Receiver of records
+	 * @param featureSet   Optional, if not null, features of this set are calculated for every record
+	 * @param depthBand    Optional, limits levels tracked by the order book to the band around the touch
+	 * @param featureWorkers   Optional, number of threads that calculate features, 0 - features are calculated
+	 *                         on the thread that pushes events
+	 */
+	OrderBookEngine(RecordSink& sink, const ordbkfeatures::FeatureSetInfo* featureSet = nullptr,
+	                const DepthBand& depthBand = DepthBand(), const size_t featureWorkers = 0);
+
+	/**
+	 * @brief Destructor.
+	 * Stops feature workers
+	 */
+	~OrderBookEngine();
+
+	/**
+	 * @brief Applies one level of the sync shot
+	 */
+	void OnSyncShot(const size_t timeStamp, const OrderType side, const double price, const double quantity);
+
+	/**
+	 * @brief Applies the update of the level
+	 */
+	void OnUpdate(const size_t timeStamp, const OrderType side, const double price, const double quantity);
+
+	/**
+	 * @brief Passes the trade to the sink, trades don't change the order book
+	 */
+	void OnTrade(const size_t timeStamp, const OrderType side, const double price, const double quantity);
+
+	/**
+	 * @brief Signals that all events with timestamps <= timeStamp are pushed,
+	 * so the pending record is passed to the sink without waiting for the next event.
+	 * If feature workers are used, waits for features of all records
+	 */
+	void OnTimestampEnd(const size_t timeStamp);
+
+	/**
+	 * @brief Passes the pending record to the sink, must be called after the last event
+	 */
+	void Finish();
+
+	/**
+	 * @return             Current order book
+	 */
+	const OrderBook& GetOrderBook() const { return orderBook_; }
+
+private:
+	void StartTimestamp(const size_t timeStamp);
+	void LogRecord();
+
+private:
+	RecordSink& sink_;
+	const ordbkfeatures::FeatureSetInfo* featureSet_;
+	OrderBook orderBook_;
+	double features_[ordbkfeatures::maxFeatureSetSize] = {};
+	std::unique_ptr<FeatureWorkerPool> featureWorkers_;
+
+	bool hasSyncShot_ = false;
+	size_t syncShotTime_ = 0;
+	bool hasPendingRecord_ = false;
+	size_t pendingTime_ = 0;
+};
+}
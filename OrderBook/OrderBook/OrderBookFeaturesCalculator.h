@@ -1,56 +1,350 @@
 #pragma once
 #include "OrderBook.h"
-#include <iostream>
-#include <optional>
+#include "ResultsWriter.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
 
 namespace ordbkfeatures
 {
 /**
- * @struct OrderBookFeatures
- * @brief Struct that stores features calculated using the order book
+ * @enum Sums
+ * @brief Sums over orders of one side that features can require.
+ * Features declare required sums as bit masks, so only needed sums are calculated.
  */
-struct OrderBookFeatures
+enum Sums : unsigned
 {
+	NONE = 0,
+	// Sum of quantities
+	QUANTITY = 1 << 0,
+	// Sum of price * quantity
+	PRICE_QUANTITY = 1 << 1,
+	// Sum of price^2 * quantity
+	SQUARED_PRICE_QUANTITY = 1 << 2,
+	// Sum of abs(price - mid price) * quantity
+	DEVIATION_QUANTITY = 1 << 3
+};
+
+/**
+ * @struct SideSums
+ * @brief Stores sums calculated for orders of one side.
+ * Sums that are not required by the feature set are left zero.
+ */
+struct SideSums
+{
+	size_t size = 0;
+	double quantity = 0.0;
+	double priceQuantity = 0.0;
+	double squaredPriceQuantity = 0.0;
+	double deviationQuantity = 0.0;
+};
+
+// Value of the feature that can't be calculated for the current order book, e.g. bid feature without bids.
+// It is the quiet NaN with its own payload, so it differs from NaN produced by calculations,
+// e.g. 0 / 0 of DollarImbalance, which is a valid result and is written as it is
+constexpr std::uint64_t missingBits = 0x7ff800000000dead;
+constexpr double missing = std::bit_cast<double>(missingBits);
+
+/**
+ * @return             True if the feature value is missing, calculated NaN is not missing
+ */
+inline bool IsMissing(const double value) { return std::bit_cast<std::uint64_t>(value) == missingBits; }
+
+/**
+ * @brief Calculates required sums over orders in one pass
+ *
+ * @param orders           Orders of one side
+ * @param midPriceCents    Mid price in cents, used only for DEVIATION_QUANTITY
+ * @param sums             Resulting sums, prices are converted from cents
+ */
+template <unsigned Required>
+void AggregateOrders(const Orders& orders, const double midPriceCents, SideSums& sums)
+{
+	sums = SideSums();
+	sums.size = orders.Size();
+
+	if constexpr (Required != NONE) {
+		for (const auto& order : orders) {
+			const double price = static_cast<double>(order.first);
+			if constexpr ((Required & QUANTITY) != 0) {
+				sums.quantity += order.second;
+			}
+			if constexpr ((Required & (PRICE_QUANTITY | SQUARED_PRICE_QUANTITY)) != 0) {
+				const double weightedPrice = price * order.second;
+				if constexpr ((Required & PRICE_QUANTITY) != 0) {
+					sums.priceQuantity += weightedPrice;
+				}
+				if constexpr ((Required & SQUARED_PRICE_QUANTITY) != 0) {
+					sums.squaredPriceQuantity += weightedPrice * price;
+				}
+			}
+			if constexpr ((Required & DEVIATION_QUANTITY) != 0) {
+				sums.deviationQuantity += std::abs(price - midPriceCents) * order.second;
+			}
+		}
+	}
+
+	if constexpr ((Required & PRICE_QUANTITY) != 0) {
+		sums.priceQuantity /= Orders::GetPriceHashMultiplier();
+	}
+	if constexpr ((Required & SQUARED_PRICE_QUANTITY) != 0) {
+		sums.squaredPriceQuantity /= Orders::GetPriceHashMultiplier();
+		sums.squaredPriceQuantity /= Orders::GetPriceHashMultiplier();
+	}
+	if constexpr ((Required & DEVIATION_QUANTITY) != 0) {
+		sums.deviationQuantity /= Orders::GetPriceHashMultiplier();
+	}
+}
+
+// Every feature is a struct with column name, sums required for bid and ask orders
+// and Calculate method that evaluates the feature from these sums.
+// Features are calculated only for non empty order book.
+
+// averageVolume = Sum of all orders quantities / number of all orders
+struct AverageVolume
+{
+	static constexpr const char* name = "AverageVolume";
+	static constexpr unsigned bidSums = QUANTITY;
+	static constexpr unsigned askSums = QUANTITY;
+	static double Calculate(const SideSums& bid, const SideSums& ask)
+	{
+		return (bid.quantity + ask.quantity) / (bid.size + ask.size);
+	}
+};
+
+// bidAverageVolume = Sum of bid orders quantities / number of bid orders
+struct BidAverageVolume
+{
+	static constexpr const char* name = "BidAverageVolume";
+	static constexpr unsigned bidSums = QUANTITY;
+	static constexpr unsigned askSums = NONE;
+	static double Calculate(const SideSums& bid, const SideSums&)
+	{
+		return bid.size ? bid.quantity / bid.size : missing;
+	}
+};
+
+// askAverageVolume = Sum of ask orders quantities / number of ask orders
+struct AskAverageVolume
+{
+	static constexpr const char* name = "AskAverageVolume";
+	static constexpr unsigned bidSums = NONE;
+	static constexpr unsigned askSums = QUANTITY;
+	static double Calculate(const SideSums&, const SideSums& ask)
+	{
+		return ask.size ? ask.quantity / ask.size : missing;
+	}
+};
+
+// volumeWeightedAveragePrice = Sum of price * quantity for all orders / Sum of all orders quantities
+struct VolumeWeightedAveragePrice
+{
+	static constexpr const char* name = "VolumeWeightedAveragePrice";
+	static constexpr unsigned bidSums = QUANTITY | PRICE_QUANTITY;
+	static constexpr unsigned askSums = QUANTITY | PRICE_QUANTITY;
+	static double Calculate(const SideSums& bid, const SideSums& ask)
+	{
+		return (bid.priceQuantity + ask.priceQuantity) / (bid.quantity + ask.quantity);
+	}
+};
+
+// bidVolumeWeightedAveragePrice = Sum of price * quantity for bid orders / Sum of bid orders quantities
+struct BidVolumeWeightedAveragePrice
+{
+	static constexpr const char* name = "BidVolumeWeightedAveragePrice";
+	static constexpr unsigned bidSums = QUANTITY | PRICE_QUANTITY;
+	static constexpr unsigned askSums = NONE;
+	static double Calculate(const SideSums& bid, const SideSums&)
+	{
+		return bid.size ? bid.priceQuantity / bid.quantity : missing;
+	}
+};
+
+// askVolumeWeightedAveragePrice = Sum of price * quantity for ask orders / Sum of ask orders quantities
+struct AskVolumeWeightedAveragePrice
+{
+	static constexpr const char* name = "AskVolumeWeightedAveragePrice";
+	static constexpr unsigned bidSums = NONE;
+	static constexpr unsigned askSums = QUANTITY | PRICE_QUANTITY;
+	static double Calculate(const SideSums&, const SideSums& ask)
+	{
+		return ask.size ? ask.priceQuantity / ask.quantity : missing;
+	}
+};
+
+// volumeWeightedAverageSquaredPrice = Sum of price^2 * quantity for all orders / Sum of all orders quantities
+struct VolumeWeightedAverageSquaredPrice
+{
+	static constexpr const char* name = "VolumeWeightedAverageSquaredPrice";
+	static constexpr unsigned bidSums = QUANTITY | SQUARED_PRICE_QUANTITY;
+	static constexpr unsigned askSums = QUANTITY | SQUARED_PRICE_QUANTITY;
+	static double Calculate(const SideSums& bid, const SideSums& ask)
+	{
+		return (bid.squaredPriceQuantity + ask.squaredPriceQuantity) / (bid.quantity + ask.quantity);
+	}
+};
+
+// bidVolumeWeightedAverageSquaredPrice = Sum of price^2 * quantity for bid orders / Sum of bid orders quantities
+struct BidVolumeWeightedAverageSquaredPrice
+{
+	static constexpr const char* name = "BidVolumeWeightedAverageSquaredPrice";
+	static constexpr unsigned bidSums = QUANTITY | SQUARED_PRICE_QUANTITY;
+	static constexpr unsigned askSums = NONE;
+	static double Calculate(const SideSums& bid, const SideSums&)
+	{
+		return bid.size ? bid.squaredPriceQuantity / bid.quantity : missing;
+	}
+};
+
+// askVolumeWeightedAverageSquaredPrice = Sum of price^2 * quantity for ask orders / Sum of ask orders quantities
+struct AskVolumeWeightedAverageSquaredPrice
+{
+	static constexpr const char* name = "AskVolumeWeightedAverageSquaredPrice";
+	static constexpr unsigned bidSums = NONE;
+	static constexpr unsigned askSums = QUANTITY | SQUARED_PRICE_QUANTITY;
+	static double Calculate(const SideSums&, const SideSums& ask)
+	{
+		return ask.size ? ask.squaredPriceQuantity / ask.quantity : missing;
+	}
+};
+
+// volumeImbalance = (b - a) / (b + a)
+// where b = Sum of bid orders quantities, a = Sum of ask orders quantities
+struct VolumeImbalance
+{
+	static constexpr const char* name = "VolumeImbalance";
+	static constexpr unsigned bidSums = QUANTITY;
+	static constexpr unsigned askSums = QUANTITY;
+	static double Calculate(const SideSums& bid, const SideSums& ask)
+	{
+		return (bid.quantity - ask.quantity) / (bid.quantity + ask.quantity);
+	}
+};
+
+// Denote abs(price - mid price) as deviation
+// b = Sum of deviation * quantity for bid orders
+// a = Sum of deviation * quantity for ask orders
+// dollarImbalance = (b - a) / (b + a)
+struct DollarImbalance
+{
+	static constexpr const char* name = "DollarImbalance";
+	static constexpr unsigned bidSums = DEVIATION_QUANTITY;
+	static constexpr unsigned askSums = DEVIATION_QUANTITY;
+	static double Calculate(const SideSums& bid, const SideSums& ask)
+	{
+		return (bid.deviationQuantity - ask.deviationQuantity) / (bid.deviationQuantity + ask.deviationQuantity);
+	}
+};
+
+/**
+ * @struct FeatureSet
+ * @brief Compile-time list of features.
+ * Calculates all sums required by the listed features in one pass over each side of the order book
+ * and evaluates features from them, so nothing that is not needed by the set is calculated.
+ */
+template <typename... Features>
+struct FeatureSet
+{
+	static constexpr size_t size = sizeof...(Features);
+	static constexpr unsigned bidSums = (Features::bidSums | ... | NONE);
+	static constexpr unsigned askSums = (Features::askSums | ... | NONE);
+	static constexpr std::array<const char*, size> names = { Features::name... };
+
 	/**
-	 * @brief Clears all stored values
+	 * @brief Calculates features for the current state of the order book.
+	 * If the order book is empty, all features are missing
+	 *
+	 * @param orderBook    Order book
+	 * @param values       Array of size elements where features are written in the order of the list
 	 */
-	void Clear();
-
-	// averageVolume = Sum of all orders quantities / number of all orders
-	std::optional<double> averageVolume;
-	// bidAverageVolume = Sum of bid orders quantities / number of bid orders
-	std::optional<double> bidAverageVolume;
-	// askAverageVolume = Sum of ask orders quantities / number of ask orders
-	std::optional<double> askAverageVolume;
-
-	// volumeWeightedAveragePrice = Sum of price * quantity for all orders / Sum of all orders quantities
-	std::optional<double> volumeWeightedAveragePrice;
-	// bidVolumeWeightedAveragePrice = Sum of price * quantity for bid orders / Sum of bid orders quantities
-	std::optional<double> bidVolumeWeightedAveragePrice;
-	// askVolumeWeightedAveragePrice = Sum of price * quantity for ask orders / Sum of ask orders quantities
-	std::optional<double> askVolumeWeightedAveragePrice;
-
-	// volumeWeightedAverageSquaredPrice = Sum of price^2 * quantity for all orders / Sum of all orders quantities
-	std::optional<double> volumeWeightedAverageSquaredPrice;
-	// bidVolumeWeightedAverageSquaredPrice = Sum of price^2 * quantity for bid orders / Sum of bid orders quantities
-	std::optional<double> bidVolumeWeightedAverageSquaredPrice;
-	// askVolumeWeightedAverageSquaredPrice = Sum of price^2 * quantity for ask orders / Sum of ask orders quantities
-	std::optional<double> askVolumeWeightedAverageSquaredPrice;
-
-	// volumeImbalance = (b - a) / (b + a)
-	// where b = Sum of bid orders quantities, a = Sum of ask orders quantities
-	std::optional<double> volumeImbalance;
-
-	// Denote abs(price - mid price) as deviation
-	// b = Sum of deviation * quantity for bid orders
-	// a = Sum of deviation * quantity for ask orders
-	// dollarImbalance = (b - a) / (b + a)
-	std::optional<double> dollarImbalance;
-};
-
-std::ostream& operator<<(std::ostream& strm, const std::optional<double>& optValue);
-std::ostream& operator<<(std::ostream& strm, const OrderBookFeatures& orderBookFeatures);
-
-void CalculateOrderBookFeatures(const OrderBook& orderBook,
-                                OrderBookFeatures& orderBookFeatures);
+	static void Calculate(const OrderBook& orderBook, double* values)
+	{
+		const Orders& bidOrders = orderBook.GetBidOrders();
+		const Orders& askOrders = orderBook.GetAskOrders();
+		const size_t bidSize = bidOrders.Size(), askSize = askOrders.Size();
+		if (!bidSize && !askSize) {
+			std::fill_n(values, size, missing);
+			return;
+		}
+
+		double midPriceCents = 0.0;
+		if constexpr (((bidSums | askSums) & DEVIATION_QUANTITY) != 0) {
+			if (bidSize && askSize) {
+				midPriceCents = bidOrders.GetBestPriceCents() + askOrders.GetBestPriceCents();
+				midPriceCents *= 0.5;
+			}
+			else if (bidSize) {
+				midPriceCents = bidOrders.GetBestPriceCents();
+			}
+			else {
+				midPriceCents = askOrders.GetBestPriceCents();
+			}
+		}
+
+		SideSums bid, ask;
+		AggregateOrders<bidSums>(bidOrders, midPriceCents, bid);
+		AggregateOrders<askSums>(askOrders, midPriceCents, ask);
+
+		size_t i = 0;
+		((values[i++] = Features::Calculate(bid, ask)), ...);
+	}
+};
+
+// Prebuilt feature sets
+using AllFeatures = FeatureSet<AverageVolume, BidAverageVolume, AskAverageVolume,
+                               VolumeWeightedAveragePrice, BidVolumeWeightedAveragePrice, AskVolumeWeightedAveragePrice,
+                               VolumeWeightedAverageSquaredPrice, BidVolumeWeightedAverageSquaredPrice,
+                               AskVolumeWeightedAverageSquaredPrice,
+                               VolumeImbalance, DollarImbalance>;
+using VolumeFeatures = FeatureSet<AverageVolume, BidAverageVolume, AskAverageVolume>;
+using PriceFeatures = FeatureSet<VolumeWeightedAveragePrice, BidVolumeWeightedAveragePrice, AskVolumeWeightedAveragePrice>;
+using ImbalanceFeatures = FeatureSet<VolumeImbalance, DollarImbalance>;
+
+// Max number of features in the feature set that can be selected at run time
+constexpr size_t maxFeatureSetSize = AllFeatures::size;
+
+/**
+ * @struct FeatureSetInfo
+ * @brief Run time description of the feature set, so it can be selected by name
+ */
+struct FeatureSetInfo
+{
+	const char* name;
+	size_t size;
+	const char* const* columns;
+	void (*calculate)(const OrderBook& orderBook, double* values);
+};
+
+template <typename Set>
+constexpr FeatureSetInfo MakeFeatureSetInfo(const char* name)
+{
+	static_assert(Set::size <= maxFeatureSetSize, "Feature set is too large");
+	return { name, Set::size, Set::names.data(), &Set::Calculate };
+}
+
+/**
+ * @return             All prebuilt feature sets: all, volume, price, imbalance
+ */
+const std::vector<FeatureSetInfo>& GetFeatureSets();
+
+/**
+ * @param name         Name of the prebuilt feature set
+ * @return             Feature set with given name or nullptr if there is no such set
+ */
+const FeatureSetInfo* FindFeatureSet(const std::string& name);
+
+/**
+ * @brief Writes feature columns names, each one is preceded by comma
+ */
+void WriteFeaturesHeader(ordwriter::ResultsWriter& results, const FeatureSetInfo& featureSet);
+
+/**
+ * @brief Writes comma separated feature values, missing values are written as empty strings,
+ * calculated NaN values are written as NaN
+ */
+void WriteFeatures(ordwriter::ResultsWriter& results, const FeatureSetInfo& featureSet, const double* values);
 }
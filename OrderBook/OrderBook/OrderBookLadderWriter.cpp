@@ -0,0 +1,81 @@
+#include "OrderBookLadderWriter.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+char* WriteValue(char* out, const double value)
+{
+	std::memcpy(out, &value, sizeof(value));
+	return out + sizeof(value);
+}
+
+template <typename Iterator>
+char* FillLevels(Iterator it, const Iterator end, const size_t depth, char* out)
+{
+	size_t level = 0;
+	for (; it != end && level < depth; ++it, ++level) {
+		out = WriteValue(out, it->first / Orders::GetPriceHashMultiplier());
+		out = WriteValue(out, it->second);
+	}
+
+	for (; level < depth; ++level) {
+		out = WriteValue(out, std::numeric_limits<double>::quiet_NaN());
+		out = WriteValue(out, 0.0);
+	}
+
+	return out;
+}
+}
+
+ordladder::LadderWriter::LadderWriter(const std::filesystem::path& path, const size_t depth,
+                                      const bool asyncFlush) :
+	depth_(depth),
+	recordSize_(sizeof(std::uint64_t) + 2 * depth * 2 * sizeof(double)),
+	file_(path, asyncFlush, std::max(recordSize_, ordwriter::BufferedFileWriter::defaultBufferSize))
+{
+	LadderFileHeader header;
+	header.depth = static_cast<std::uint32_t>(depth_);
+	header.recordSize = static_cast<std::uint32_t>(recordSize_);
+	file_.Write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+ordladder::LadderWriter::~LadderWriter()
+{
+	Close();
+}
+
+bool ordladder::LadderWriter::IsOpen() const
+{
+	return file_.IsOpen();
+}
+
+void ordladder::LadderWriter::Write(const size_t timeStamp, const OrderBook& orderBook)
+{
+	char* record = file_.Reserve(recordSize_);
+	const std::uint64_t time = timeStamp;
+	std::memcpy(record, &time, sizeof(time));
+
+	const Orders& bidOrders = orderBook.GetBidOrders();
+	const Orders& askOrders = orderBook.GetAskOrders();
+	char* levels = record + sizeof(time);
+	levels = FillLevels(bidOrders.rbegin(), bidOrders.rend(), depth_, levels);
+	FillLevels(askOrders.begin(), askOrders.end(), depth_, levels);
+
+	file_.Commit(recordSize_);
+	++rowCount_;
+}
+
+void ordladder::LadderWriter::Close()
+{
+	if (!file_.IsOpen()) {
+		return;
+	}
+
+	// Update the row count in the header
+	const std::uint64_t rowCount = rowCount_;
+	file_.WriteAt(offsetof(LadderFileHeader, rowCount), reinterpret_cast<const char*>(&rowCount), sizeof(rowCount));
+	file_.Close();
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "OrderBook.h"
+#include "ResultsWriter.h"
+#include <cstdint>
+#include <filesystem>
+
+namespace ordladder
+{
+/**
+ * @struct LadderFileHeader
+ * @brief Fixed size header written at the beginning of the ladder file.
+ * The header is followed by rowCount records of recordSize bytes each.
+ * Every record has following layout (all values are little endian):
+ * uint64 TimeStamp, double Levels[2][depth][2]
+ * where the first index is side (0 - bids, 1 - asks), the second one is level number
+ * starting from the best price and the last one is (price, quantity).
+ * Missing levels are stored as price = NaN and quantity = 0.
+ *
+ * So the file can be memory-mapped, e.g. with numpy:
+ * np.memmap(path, dtype=[('ts', '<u8'), ('levels', '<f8', (2, depth, 2))], mode='r', offset=headerSize)
+ */
+struct LadderFileHeader
+{
+	char magic[8] = { 'O', 'B', 'L', 'A', 'D', 'D', 'E', 'R' };
+	std::uint32_t version = 1;
+	std::uint32_t headerSize = sizeof(LadderFileHeader);
+	std::uint32_t depth = 0;
+	std::uint32_t recordSize = 0;
+	// Number of records, it is updated when the writer is closed.
+	// While the file is streaming, use (file size - headerSize) / recordSize instead
+	std::uint64_t rowCount = 0;
+	char reserved[32] = {};
+};
+
+static_assert(sizeof(LadderFileHeader) == 64, "Ladder file header must be 64 bytes long");
+
+/**
+ * @class LadderWriter
+ * @brief Streams top depth levels of both sides of the order book to a binary file.
+ * Records are filled straight from the best price iteration of Orders into a reusable buffer
+ * of BufferedFileWriter, so no allocations are made per record.
+ */
+class LadderWriter
+{
+public:
+	/**
+	 * @brief Constructor.
+	 * Opens the file and writes the header
+	 *
+	 * @param path         Path to the resulting binary file
+	 * @param depth        Number of levels stored for each side
+	 * @param asyncFlush   If true, buffers are written to the file by the background thread
+	 */
+	LadderWriter(const std::filesystem::path& path, const size_t depth, const bool asyncFlush = false);
+
+	/**
+	 * @brief Destructor.
+	 * Flushes buffered records and finalizes the header
+	 */
+	~LadderWriter();
+
+	LadderWriter(const LadderWriter&) = delete;
+	LadderWriter& operator=(const LadderWriter&) = delete;
+
+	/**
+	 * @return             True if the file was opened successfully
+	 */
+	bool IsOpen() const;
+
+	/**
+	 * @brief Appends the record with top levels of the order book for given timestamp
+	 *
+	 * @param timeStamp    Timestamp of the record
+	 * @param orderBook    Current order book state
+	 */
+	void Write(const size_t timeStamp, const OrderBook& orderBook);
+
+	/**
+	 * @brief Writes buffered records, updates the row count in the header and closes the file
+	 */
+	void Close();
+
+	/**
+	 * @return             Number of levels stored for each side
+	 */
+	size_t GetDepth() const { return depth_; }
+
+	/**
+	 * @return             Number of written records
+	 */
+	size_t GetRowCount() const { return rowCount_; }
+
+private:
+	const size_t depth_;
+	const size_t recordSize_;
+	size_t rowCount_ = 0;
+	ordwriter::BufferedFileWriter file_;
+};
+}
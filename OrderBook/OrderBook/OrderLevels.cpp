@@ -0,0 +1,185 @@
+#include "OrderLevels.h"
+#include <algorithm>
+#include <atomic>
+
+OrderLevels::const_iterator& OrderLevels::const_iterator::operator++()
+{
+	if (++position_ == (*chunks_)[chunk_]->size) {
+		++chunk_;
+		position_ = 0;
+	}
+	return *this;
+}
+
+OrderLevels::const_iterator& OrderLevels::const_iterator::operator--()
+{
+	if (position_ == 0) {
+		position_ = (*chunks_)[--chunk_]->size;
+	}
+	--position_;
+	return *this;
+}
+
+void OrderLevels::clear()
+{
+	chunks_.clear();
+	size_ = 0;
+}
+
+OrderLevels::const_iterator OrderLevels::find(const std::size_t price) const
+{
+	const std::size_t chunk = FindChunk(price);
+	if (chunk == chunks_.size()) {
+		return end();
+	}
+
+	const Chunk& levels = *chunks_[chunk];
+	const auto it = std::lower_bound(levels.levels, levels.levels + levels.size, price,
+	                                 [](const value_type& level, const std::size_t price) { return level.first < price; });
+	if (it == levels.levels + levels.size || it->first != price) {
+		return end();
+	}
+	return const_iterator(&chunks_, chunk, it - levels.levels);
+}
+
+void OrderLevels::insert_or_assign(const std::size_t price, const double quantity)
+{
+	if (chunks_.empty()) {
+		chunks_.push_back(std::make_shared<Chunk>());
+		chunks_.back()->levels[0] = value_type(price, quantity);
+		chunks_.back()->size = 1;
+		size_ = 1;
+		return;
+	}
+
+	// Level that is greater than all levels goes to the last chunk
+	std::size_t chunk = std::min(FindChunk(price), chunks_.size() - 1);
+	Chunk* levels = &GetMutableChunk(chunk);
+	const auto less = [](const value_type& level, const std::size_t price) { return level.first < price; };
+	std::size_t position = std::lower_bound(levels->levels, levels->levels + levels->size, price, less) - levels->levels;
+	if (position < levels->size && levels->levels[position].first == price) {
+		levels->levels[position].second = quantity;
+		return;
+	}
+
+	// Full chunk is split in halves
+	if (levels->size == maxChunkSize) {
+		auto upper = std::make_shared<Chunk>();
+		constexpr std::size_t half = maxChunkSize / 2;
+		std::copy(levels->levels + half, levels->levels + maxChunkSize, upper->levels);
+		upper->size = maxChunkSize - half;
+		levels->size = half;
+		chunks_.insert(chunks_.begin() + chunk + 1, std::move(upper));
+
+		if (position > half) {
+			++chunk;
+			position -= half;
+		}
+		levels = chunks_[chunk].get();
+	}
+
+	std::copy_backward(levels->levels + position, levels->levels + levels->size, levels->levels + levels->size + 1);
+	levels->levels[position] = value_type(price, quantity);
+	++levels->size;
+	++size_;
+}
+
+std::size_t OrderLevels::erase(const std::size_t price)
+{
+	const auto it = find(price);
+	if (it == end()) {
+		return 0;
+	}
+
+	EraseFromChunk(it.chunk_, it.position_, it.position_ + 1);
+	MergeChunks(it.chunk_);
+	return 1;
+}
+
+void OrderLevels::erase(const_iterator first, const_iterator last)
+{
+	if (first == last) {
+		return;
+	}
+
+	// Levels are removed from the last chunk to the first one, so indexes of chunks before stay valid
+	if (last.chunk_ < chunks_.size() && last.position_ > 0) {
+		EraseFromChunk(last.chunk_, first.chunk_ == last.chunk_ ? first.position_ : 0, last.position_);
+	}
+
+	if (first.chunk_ < last.chunk_) {
+		const std::size_t firstWholeChunk = first.position_ > 0 ? first.chunk_ + 1 : first.chunk_;
+		for (std::size_t chunk = firstWholeChunk; chunk < last.chunk_; ++chunk) {
+			size_ -= chunks_[chunk]->size;
+		}
+		chunks_.erase(chunks_.begin() + firstWholeChunk, chunks_.begin() + last.chunk_);
+
+		if (first.position_ > 0) {
+			EraseFromChunk(first.chunk_, first.position_, chunks_[first.chunk_]->size);
+		}
+	}
+
+	MergeChunks(first.chunk_);
+}
+
+std::size_t OrderLevels::FindChunk(const std::size_t price) const
+{
+	// The first chunk whose last level is not less than the price
+	return std::lower_bound(chunks_.begin(), chunks_.end(), price,
+	                        [](const std::shared_ptr<Chunk>& chunk, const std::size_t price)
+	                        { return chunk->levels[chunk->size - 1].first < price; }) - chunks_.begin();
+}
+
+OrderLevels::Chunk& OrderLevels::GetMutableChunk(const std::size_t chunk)
+{
+	std::shared_ptr<Chunk>& levels = chunks_[chunk];
+	if (levels.use_count() > 1) {
+		levels = std::make_shared<Chunk>(*levels);
+	}
+	else {
+		// Other copies could have released the chunk on other threads,
+		// their reads of the chunk must happen before it is modified
+		std::atomic_thread_fence(std::memory_order_acquire);
+	}
+	return *levels;
+}
+
+void OrderLevels::EraseFromChunk(const std::size_t chunk, const std::size_t first, const std::size_t last)
+{
+	size_ -= last - first;
+	if (last - first == chunks_[chunk]->size) {
+		chunks_.erase(chunks_.begin() + chunk);
+		return;
+	}
+
+	Chunk& levels = GetMutableChunk(chunk);
+	std::copy(levels.levels + last, levels.levels + levels.size, levels.levels + first);
+	levels.size -= last - first;
+}
+
+void OrderLevels::MergeChunks(const std::size_t chunk)
+{
+	// Small neighbouring chunks are merged, so the number of chunks stays proportional to the number of levels
+	if (chunk > chunks_.size()) {
+		return;
+	}
+
+	const auto isSmall = [this](const std::size_t first) {
+		return first + 1 < chunks_.size() &&
+		       chunks_[first]->size + chunks_[first + 1]->size <= maxChunkSize / 2;
+	};
+
+	std::size_t first = chunk;
+	if (!isSmall(first)) {
+		if (first == 0 || !isSmall(first - 1)) {
+			return;
+		}
+		--first;
+	}
+
+	Chunk& levels = GetMutableChunk(first);
+	const Chunk& next = *chunks_[first + 1];
+	std::copy(next.levels, next.levels + next.size, levels.levels + levels.size);
+	levels.size += next.size;
+	chunks_.erase(chunks_.begin() + first + 1);
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * @class OrderLevels
+ * @brief Sorted by price storage of order levels with copy-on-write structural sharing.
+ * Levels are stored in small sorted chunks held by shared pointers, so a copy of the storage
+ * only shares its chunks. A chunk is copied when it is modified while some other copy still holds it,
+ * so an old copy stays an immutable version of levels and can be read by another thread
+ * while the original one is being modified.
+ *
+ * Interface follows std::map<size_t, double> with key = price in cents and value = quantity,
+ * but levels are accessible only via const iterators.
+ */
+class OrderLevels
+{
+public:
+	// first - price in cents, second - quantity
+	using value_type = std::pair<std::size_t, double>;
+
+	// Max number of levels in one chunk
+	static constexpr std::size_t maxChunkSize = 64;
+
+private:
+	struct Chunk
+	{
+		std::size_t size = 0;
+		value_type levels[maxChunkSize];
+	};
+
+	using Chunks = std::vector<std::shared_ptr<Chunk>>;
+
+public:
+	class const_iterator
+	{
+	public:
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = OrderLevels::value_type;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const value_type*;
+		using reference = const value_type&;
+
+		const_iterator() = default;
+
+		reference operator*() const { return (*chunks_)[chunk_]->levels[position_]; }
+		pointer operator->() const { return &**this; }
+
+		const_iterator& operator++();
+		const_iterator operator++(int) { const_iterator it = *this; ++*this; return it; }
+		const_iterator& operator--();
+		const_iterator operator--(int) { const_iterator it = *this; --*this; return it; }
+
+		bool operator==(const const_iterator& other) const
+		{
+			return chunk_ == other.chunk_ && position_ == other.position_;
+		}
+		bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+	private:
+		friend class OrderLevels;
+
+		const_iterator(const Chunks* chunks, const std::size_t chunk, const std::size_t position) :
+			chunks_(chunks), chunk_(chunk), position_(position)
+		{}
+
+		const Chunks* chunks_ = nullptr;
+		std::size_t chunk_ = 0;
+		std::size_t position_ = 0;
+	};
+
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+public:
+	bool empty() const { return size_ == 0; }
+	std::size_t size() const { return size_; }
+
+	/**
+	 * @brief Removes all levels, chunks held by other copies stay untouched
+	 */
+	void clear();
+
+	const_iterator begin() const { return const_iterator(&chunks_, 0, 0); }
+	const_iterator end() const { return const_iterator(&chunks_, chunks_.size(), 0); }
+
+	const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+	const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+	/**
+	 * @return             Iterator to the level with given price or end() if there is no such level
+	 */
+	const_iterator find(const std::size_t price) const;
+
+	/**
+	 * @brief Sets quantity of the level, adds the level if it does not exist
+	 */
+	void insert_or_assign(const std::size_t price, const double quantity);
+
+	/**
+	 * @brief Removes the level with given price
+	 *
+	 * @return             Number of removed levels: 0 or 1
+	 */
+	std::size_t erase(const std::size_t price);
+
+	/**
+	 * @brief Removes levels in the range [first, last)
+	 */
+	void erase(const_iterator first, const_iterator last);
+
+private:
+	std::size_t FindChunk(const std::size_t price) const;
+	Chunk& GetMutableChunk(const std::size_t chunk);
+	void EraseFromChunk(const std::size_t chunk, const std::size_t first, const std::size_t last);
+	void MergeChunks(const std::size_t chunk);
+
+private:
+	Chunks chunks_;
+	std::size_t size_ = 0;
+};
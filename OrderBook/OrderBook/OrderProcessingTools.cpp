@@ -1,6 +1,8 @@
 #include "OrderProcessingTools.h"
-#include <sstream>
+#include <charconv>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 
 struct LineInfo
 {
@@ -10,160 +12,202 @@ struct LineInfo
 	OrderType side = OrderType::BID;
 };
 
-LineInfo& ParseLine(const std::string& line, LineInfo& lineInfo)
+template <typename T>
+const char* ParseItem(const char* first, const char* last, T& value)
 {
-	std::stringstream ss(line);
-	std::string item;
+	const auto result = std::from_chars(first, last, value);
+	if (result.ec != std::errc()) {
+		throw std::invalid_argument("Could not parse line: " + std::string(first, last));
+	}
 
-	std::getline(ss, item, ',');
-	std::stringstream(item) >> lineInfo.time;
+	// Skip the separator
+	return result.ptr < last ? result.ptr + 1 : last;
+}
 
-	std::getline(ss, item, ',');
-	lineInfo.side = static_cast<OrderType>(std::stoi(item));
+LineInfo& ParseLine(const std::string_view line, LineInfo& lineInfo)
+{
+	const char* last = line.data() + line.size();
+	const char* item = ParseItem(line.data(), last, lineInfo.time);
 
-	std::getline(ss, item, ',');
-	lineInfo.price = std::stod(item);
+	int side = 0;
+	item = ParseItem(item, last, side);
+	lineInfo.side = static_cast<OrderType>(side);
 
-	std::getline(ss, item, ',');
-	lineInfo.quantity = std::stod(item);
+	item = ParseItem(item, last, lineInfo.price);
+	ParseItem(item, last, lineInfo.quantity);
 
 	return lineInfo;
 }
 
-void LogCurrentBBO(std::ofstream& results, const OrderBook& orderBook, const size_t timeStamp,
-                   const bool logFeatures = false)
+/**
+ * @brief Reads lines of the file stream, the header is skipped
+ */
+class StreamLineReader
 {
-	results << timeStamp << ",";
-	double price = orderBook.GetBestBidPrice();
-	if (price > 0) {
-		results << price;
+public:
+	StreamLineReader(std::ifstream& file) :
+		file_(file)
+	{
+		std::getline(file_, line_);
 	}
-	results << ",";
-	price = orderBook.GetBestAskPrice();
-	if (price > 0) {
-		results << price;
+
+	bool ReadLine(LineInfo& lineInfo)
+	{
+		if (!std::getline(file_, line_)) {
+			return false;
+		}
+
+		ParseLine(line_, lineInfo);
+		return true;
 	}
 
-	if (logFeatures) {
-		results << ",";
-		static ordbkfeatures::OrderBookFeatures orderBookFeatures;
-		ordbkfeatures::CalculateOrderBookFeatures(orderBook, orderBookFeatures);
-		results << orderBookFeatures;
+private:
+	std::ifstream& file_;
+	std::string line_;
+};
+
+/**
+ * @brief Reads lines of files prefetched by ordfiles::PrefetchingLineReader
+ */
+class PrefetchedLineReader
+{
+public:
+	PrefetchedLineReader(std::vector<std::filesystem::path> paths) :
+		reader_(std::move(paths))
+	{}
+
+	bool ReadLine(LineInfo& lineInfo)
+	{
+		std::string_view line;
+		if (!reader_.ReadLine(line)) {
+			return false;
+		}
+
+		ParseLine(line, lineInfo);
+		return true;
 	}
 
-	results << std::endl;
-}
+private:
+	ordfiles::PrefetchingLineReader reader_;
+};
 
-void ProcessSyncShotsUntillCurrentUpdate(std::ifstream& syncShots, std::ifstream& updates,
-                                         std::ofstream& results, OrderBook& orderBook,
-                                         LineInfo& syncShotLineInfo,
-                                         const LineInfo& updateLineInfo,
-                                         const bool logFeatures = false)
+template <typename LineReader>
+void PushSyncShotsAndUpdates(LineReader& syncShots, LineReader& updates, ordengine::OrderBookEngine& engine)
 {
-	// Clear orderBook before initializing it from the current sync shot
-	orderBook.Clear();
-
-	// Handle the current sync shot that was already parse before
-	// We don't need to check whether the sync shots file is not over here
-	// because if it had been over, the cycle would've been broken
-	orderBook.HandleOrderUpdate(syncShotLineInfo.price, syncShotLineInfo.quantity, syncShotLineInfo.side);
-	size_t prevSyncShotTime = syncShotLineInfo.time;
-	static std::string line;
-
-	// We iterate over syncshots until we get synchot that happened after the current update
-	// If the current syncshot and the cuurrent update happened at the same timestamp,
-	// we parse the sync shot first
-	// If the updates file is over, we iterate till the end of the sync shots file
-	while (std::getline(syncShots, line) &&
-          (ParseLine(line, syncShotLineInfo).time <= updateLineInfo.time || !updates))
+	LineInfo syncShotLineInfo, updateLineInfo;
+	bool hasSyncShot = syncShots.ReadLine(syncShotLineInfo);
+	bool hasUpdate = updates.ReadLine(updateLineInfo);
+
+	// Both files are sorted by timestamps, so we merge them
+	// If the sync shot and the update have the same timestamp, the sync shot goes first
+	while (hasSyncShot || hasUpdate)
 	{
-		if (prevSyncShotTime < syncShotLineInfo.time) {
-			// It means that the syncshot is over
-			// But the cycle is not broken because next syncshot happened before the current update
-			// Hence, we need to log bbo here
-			LogCurrentBBO(results, orderBook, prevSyncShotTime, logFeatures);
-			orderBook.Clear();
+		if (hasSyncShot && (!hasUpdate || syncShotLineInfo.time <= updateLineInfo.time)) {
+			engine.OnSyncShot(syncShotLineInfo.time, syncShotLineInfo.side,
+                              syncShotLineInfo.price, syncShotLineInfo.quantity);
+			hasSyncShot = syncShots.ReadLine(syncShotLineInfo);
+		}
+		else {
+			engine.OnUpdate(updateLineInfo.time, updateLineInfo.side,
+                            updateLineInfo.price, updateLineInfo.quantity);
+			hasUpdate = updates.ReadLine(updateLineInfo);
 		}
-		orderBook.HandleOrderUpdate(syncShotLineInfo.price, syncShotLineInfo.quantity, syncShotLineInfo.side);
-		prevSyncShotTime = syncShotLineInfo.time;
 	}
+	engine.Finish();
+}
+
+ordtools::ResultsSink::ResultsSink(ordwriter::ResultsWriter& results,
+                                   const ordbkfeatures::FeatureSetInfo* featureSet,
+                                   ordladder::LadderWriter* ladderWriter, const bool bandFlags) :
+	results_(results),
+	featureSet_(featureSet),
+	ladderWriter_(ladderWriter),
+	bandFlags_(bandFlags)
+{}
 
-	// We can't log bbo until we make sure that the current update didn't happen
-	// at the same time as previous sync shot
-	if (updateLineInfo.time > prevSyncShotTime || !updates) {
-		LogCurrentBBO(results, orderBook, prevSyncShotTime, logFeatures);
+void ordtools::ResultsSink::WriteHeader()
+{
+	results_.Write("TimeStamp,BestBid,BestAsk");
+	if (featureSet_) {
+		ordbkfeatures::WriteFeaturesHeader(results_, *featureSet_);
 	}
+	if (bandFlags_) {
+		results_.Write(",BandExhausted");
+	}
+	results_.EndRow();
 }
 
-void ProcessUpdatesUntillCurrentSyncShot(std::ifstream& syncShots, std::ifstream& updates,
-                                         std::ofstream& results, OrderBook& orderBook,
-	                                     const LineInfo& syncShotLineInfo,
-	                                     LineInfo& updateLineInfo,
-                                         const bool logFeatures = false)
+void ordtools::ResultsSink::OnRecord(const ordengine::BookRecord& record)
 {
-	// Handle the current update that was already parse before
-	orderBook.HandleOrderUpdate(updateLineInfo.price, updateLineInfo.quantity, updateLineInfo.side);
+	if (ladderWriter_) {
+		ladderWriter_->Write(record.timeStamp, *record.orderBook);
+	}
 
-	size_t prevUpdateTime = updateLineInfo.time;
-	static std::string line;
+	results_.Write(record.timeStamp);
+	results_.WriteSeparator();
+	if (record.bestBidPrice > 0) {
+		results_.Write(record.bestBidPrice);
+	}
+	results_.WriteSeparator();
+	if (record.bestAskPrice > 0) {
+		results_.Write(record.bestAskPrice);
+	}
 
-	// We iterate over updates until we get the update that happened
-	// after or at the sime time as the current syncshot
-	// If the sync shots file is over, we iterate till the end of the updates file
-	while (std::getline(updates, line) &&
-           (ParseLine(line, updateLineInfo).time < syncShotLineInfo.time || !syncShots))
-	{
-		if (prevUpdateTime < updateLineInfo.time) {
-			LogCurrentBBO(results, orderBook, prevUpdateTime, logFeatures);
-		}
-		orderBook.HandleOrderUpdate(updateLineInfo.price, updateLineInfo.quantity, updateLineInfo.side);
-		prevUpdateTime = updateLineInfo.time;
+	if (record.featureSet) {
+		results_.WriteSeparator();
+		ordbkfeatures::WriteFeatures(results_, *record.featureSet, record.features);
+	}
+
+	if (bandFlags_) {
+		results_.Write(record.bandExhausted ? ",1" : ",0");
 	}
 
-	// When the cycle is over we need to log one more update
-	LogCurrentBBO(results, orderBook, prevUpdateTime, logFeatures);
+	results_.EndRow();
 }
 
 void ordtools::ProcessSyncShotsAndUpdates(std::ifstream& syncShots, std::ifstream& updates,
-                                          std::ofstream& results, const bool logFeatures)
+                                          ordwriter::ResultsWriter& results,
+                                          const ordbkfeatures::FeatureSetInfo* featureSet,
+                                          ordladder::LadderWriter* ladderWriter,
+                                          const DepthBand& depthBand,
+                                          DepthBandStatistics* bandStatistics,
+                                          const size_t featureWorkers)
 {
-	// Skip columns
-	static std::string line;
-	std::getline(syncShots, line);
-	std::getline(updates, line);
-
-	OrderBook orderBook;
-	LineInfo syncShotLineInfo, updateLineInfo;
+	ResultsSink sink(results, featureSet, ladderWriter, depthBand.Enabled());
+	ordengine::OrderBookEngine engine(sink, featureSet, depthBand, featureWorkers);
+	sink.WriteHeader();
 
-	// Get first timestamp from sync shots
-	std::getline(syncShots, line);
-	ParseLine(line, syncShotLineInfo);
-
-	// Skip all updates that happened before first sync shot
-	while (std::getline(updates, line) &&
-           ParseLine(line, updateLineInfo).time < syncShotLineInfo.time)
-	{}
+	StreamLineReader syncShotsReader(syncShots), updatesReader(updates);
+	PushSyncShotsAndUpdates(syncShotsReader, updatesReader, engine);
 
-	results << "TimeStamp,BestBid,BestAsk";
-	if (logFeatures) {
-		results << ",AverageVolume,BidAverageVolume,AskAverageVolume,"
-                   "VolumeWeightedAveragePrice,BidVolumeWeightedAveragePrice,AskVolumeWeightedAveragePrice,"
-                   "VolumeWeightedAverageSquaredPrice,BidVolumeWeightedAverageSquaredPrice,AskVolumeWeightedAverageSquaredPrice,"
-                   "VolumeImbalance,DollarImbalance";
+	if (bandStatistics) {
+		*bandStatistics = engine.GetOrderBook().GetDepthBandStatistics();
 	}
-	results << std::endl;
+}
 
-	while (syncShots || updates)
-	{
-		ProcessSyncShotsUntillCurrentUpdate(syncShots, updates, results, orderBook,
-                                            syncShotLineInfo, updateLineInfo, logFeatures);
+void ordtools::ProcessDays(const std::vector<ordfiles::DayFiles>& days, ordwriter::ResultsWriter& results,
+                           const ordbkfeatures::FeatureSetInfo* featureSet,
+                           ordladder::LadderWriter* ladderWriter,
+                           const DepthBand& depthBand,
+                           DepthBandStatistics* bandStatistics,
+                           const size_t featureWorkers)
+{
+	ResultsSink sink(results, featureSet, ladderWriter, depthBand.Enabled());
+	ordengine::OrderBookEngine engine(sink, featureSet, depthBand, featureWorkers);
+	sink.WriteHeader();
+
+	// Files of all days are read as one sync shots file and one updates file,
+	// so the order book state is carried over day boundaries
+	std::vector<std::filesystem::path> syncShotsPaths, updatesPaths;
+	for (const auto& day : days) {
+		syncShotsPaths.push_back(day.syncShots);
+		updatesPaths.push_back(day.updates);
+	}
 
-		// If the updates file is over, there is no current update
-		if (!updates) {
-			continue;
-		}
+	PrefetchedLineReader syncShotsReader(std::move(syncShotsPaths)), updatesReader(std::move(updatesPaths));
+	PushSyncShotsAndUpdates(syncShotsReader, updatesReader, engine);
 
-		ProcessUpdatesUntillCurrentSyncShot(syncShots, updates, results, orderBook,
-                                            syncShotLineInfo, updateLineInfo, logFeatures);
+	if (bandStatistics) {
+		*bandStatistics = engine.GetOrderBook().GetDepthBandStatistics();
 	}
 }
\ No newline at end of file
@@ -1,27 +1,95 @@
 #pragma once
-#include "OrderBookFeaturesCalculator.h"
+#include "FileSequencer.h"
+#include "OrderBookEngine.h"
+#include "OrderBookLadderWriter.h"
 #include <fstream>
 
 namespace ordtools
 {
+/**
+ * @class ResultsSink
+ * @brief Writes records of OrderBookEngine to the results file and optionally to the ladder file.
+ *
+ * If featureSet is null, the results file has following structure:
+ * TimeStamp,BestBidPrice,BestAskPrice
+ * Else, structure is following
+ * TimeStamp,BestBidPrice,BestAskPrice,Feature_1,...,Feature_n
+ * where features are the ones listed in the feature set.
+ * If bandFlags is true, the last column is BandExhausted: 1 if the depth band of some side is exhausted,
+ * so best prices and features of the row may be wrong, else 0
+ */
+class ResultsSink : public ordengine::RecordSink
+{
+public:
+	/**
+	 * @brief Constructor.
+	 *
+	 * @param results      Results writer to where order book statistics is logged
+	 * @param featureSet   Optional, feature set the engine was created with, used for the header
+	 * @param ladderWriter Optional, if not null, order book ladder is written to it for every record
+	 * @param bandFlags    Optional, if true, the BandExhausted column is written
+	 */
+	ResultsSink(ordwriter::ResultsWriter& results, const ordbkfeatures::FeatureSetInfo* featureSet = nullptr,
+	            ordladder::LadderWriter* ladderWriter = nullptr, const bool bandFlags = false);
+
+	/**
+	 * @brief Writes columns names to the results file
+	 */
+	void WriteHeader();
+
+	void OnRecord(const ordengine::BookRecord& record) override;
+
+private:
+	ordwriter::ResultsWriter& results_;
+	const ordbkfeatures::FeatureSetInfo* featureSet_;
+	ordladder::LadderWriter* ladderWriter_;
+	const bool bandFlags_;
+};
+
 /**
  * @brief Processes all order initial states from sync shots file and all order updates from updates file
  * and logs best bid and ask prices for every unique timestamp in both file.
+ * Files are merged by timestamps and pushed to OrderBookEngine, so its rules are applied:
  * All updates happened before first sync shot are ignored.
  * If some updates have the same timestamp, only the last update is logged.
  * If updates following after the sync shot have the same timestamp as this sync shot,
  * order book for the last update is logged.
  *
- * If logFeatures is false, the resulting filestream has following structure:
- * TimeStamp,BestBidPrice,BestAskPrice
- * If logFeatures is true, structure is following
- * TimeStamp,BestBidPrice,BestAskPrice,Feature_1,...,Feature_n
+ * The structure of the results file is described in ResultsSink.
+ * If ladderWriter is specified, top levels of both sides are also written to it
+ * for every logged timestamp (see ordladder::LadderWriter for the file layout).
  *
  * @param syncShots    Sync shots input file stream
  * @param updates      Updates input file stream
- * @param resutls      Results output file stream to where order book statistics is logged
- * @logFeatures        Optional, if true, features calculated by OrderBookFeatureCalculator are logged
+ * @param resutls      Results writer to where order book statistics is logged
+ * @featureSet         Optional, if not null, features of this set are calculated and logged
+ * @ladderWriter       Optional, if not null, order book ladder is written to it for every logged timestamp
+ * @depthBand          Optional, limits levels tracked by the order book to the band around the touch,
+ *                     if it is enabled, the BandExhausted column is written
+ * @bandStatistics     Optional, if not null, depth band counters are stored to it when processing is finished
+ * @featureWorkers     Optional, number of threads that calculate features, results are the same for any number
  */
 void ProcessSyncShotsAndUpdates(std::ifstream& syncShots, std::ifstream& updates,
-	                            std::ofstream& results, const bool logFeatures = false);
+	                            ordwriter::ResultsWriter& results,
+	                            const ordbkfeatures::FeatureSetInfo* featureSet = nullptr,
+	                            ordladder::LadderWriter* ladderWriter = nullptr,
+	                            const DepthBand& depthBand = DepthBand(),
+	                            DepthBandStatistics* bandStatistics = nullptr,
+	                            const size_t featureWorkers = 0);
+
+/**
+ * @brief Processes sync shots and updates files of several days as one continuous stream:
+ * the order book state is carried over day boundaries, so updates of the next day
+ * that happened before its first sync shot are applied to the order book of the previous day.
+ * Files are read ahead by background threads, the next day files are opened while the current day is processed.
+ * Rules and parameters are the same as for ProcessSyncShotsAndUpdates.
+ *
+ * @param days         Files of days sorted by days
+ */
+void ProcessDays(const std::vector<ordfiles::DayFiles>& days, ordwriter::ResultsWriter& results,
+                 const ordbkfeatures::FeatureSetInfo* featureSet = nullptr,
+                 ordladder::LadderWriter* ladderWriter = nullptr,
+                 const DepthBand& depthBand = DepthBand(),
+                 DepthBandStatistics* bandStatistics = nullptr,
+                 const size_t featureWorkers = 0);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "Orders.h"
 #include <algorithm>
 #include <cmath>
+#include <iterator>
 
 Orders::Orders(const OrderType orderType) : 
 	orderType_(orderType)
@@ -14,6 +15,9 @@ bool Orders::Empty() const
 void Orders::Clear()
 {
 	orders_.clear();
+	reserve_.clear();
+	levelsLost_ = false;
+	bandExhausted_ = false;
 }
 
 size_t Orders::Size() const
@@ -21,6 +25,11 @@ size_t Orders::Size() const
 	return orders_.size();
 }
 
+void Orders::SetDepthBand(const DepthBand& depthBand)
+{
+	depthBand_ = depthBand;
+}
+
 OrderType Orders::GetOrderType() const
 {
 	return orderType_;
@@ -29,12 +38,16 @@ OrderType Orders::GetOrderType() const
 void Orders::HandleOrderUpdate(const double price, const double quantity)
 {
 	const size_t priceHash = GetPriceCents(price);
+	if (depthBand_.Enabled()) {
+		HandleBandedOrderUpdate(priceHash, quantity);
+		return;
+	}
 
 	if (std::abs(quantity) <= 1e-6) {
 		orders_.erase(priceHash);
 	}
 	else {
-		orders_[priceHash] = quantity;
+		orders_.insert_or_assign(priceHash, quantity);
 	}
 }
 
@@ -68,7 +81,16 @@ size_t Orders::GetBestPriceCents() const
 
 void Orders::ValidateOrdersToOtherSide(const Orders& otherSide)
 {
-	if (Empty() || otherSide.Empty()) {
+	RemoveCrossingOrders(orders_, otherSide);
+	if (depthBand_.Enabled()) {
+		RemoveCrossingOrders(reserve_, otherSide);
+		RebalanceBand();
+	}
+}
+
+void Orders::RemoveCrossingOrders(OrdersMap& orders, const Orders& otherSide) const
+{
+	if (orders.empty() || otherSide.Empty()) {
 		return;
 	}
 
@@ -77,30 +99,168 @@ void Orders::ValidateOrdersToOtherSide(const Orders& otherSide)
 	case OrderType::BID:
 	{
 		if (otherSide.GetOrderType() == OrderType::ASK &&
-			orders_.rbegin()->first >= otherSide.GetBestPriceCents())
+			orders.rbegin()->first >= otherSide.GetBestPriceCents())
 		{
 			const auto lmbd = [&otherSide](const Order& order)
 			{ return order.first >= otherSide.GetBestPriceCents(); };
-			const auto it = std::find_if(orders_.begin(), orders_.end(), lmbd);
-			orders_.erase(it, orders_.end());
+			const auto it = std::find_if(orders.begin(), orders.end(), lmbd);
+			orders.erase(it, orders.end());
 		}
 		break;
 	}
 	case OrderType::ASK:
 	{
 		if (otherSide.GetOrderType() == OrderType::BID &&
-			otherSide.GetBestPriceCents() >= orders_.begin()->first)
+			otherSide.GetBestPriceCents() >= orders.begin()->first)
 		{
 			const auto lmbd = [&otherSide](const Order& order)
 			{ return order.first > otherSide.GetBestPriceCents(); };
-			const auto it = std::find_if(orders_.begin(), orders_.end(), lmbd);
-			orders_.erase(orders_.begin(), it);
+			const auto it = std::find_if(orders.begin(), orders.end(), lmbd);
+			orders.erase(orders.begin(), it);
 		}
 		break;
 	}
 	}
 }
 
+void Orders::HandleBandedOrderUpdate(const size_t priceHash, const double quantity)
+{
+	// All stored levels are within 2 * maxDeviation from the touch and the reserve stores at most
+	// maxLevels levels, so the level that is outside these limits is not stored and its update can be dropped
+	const bool outsideDeviation = depthBand_.maxDeviation > 0.0 && !orders_.empty() &&
+	                              GetDistanceFromTouch(priceHash) > 2.0 * depthBand_.maxDeviation;
+	const bool outsideLevels = depthBand_.maxLevels && reserve_.size() >= depthBand_.maxLevels &&
+	                           IsBetter(GetWorst(reserve_)->first, priceHash);
+	if (outsideDeviation || outsideLevels) {
+		++bandStatistics_.droppedUpdates;
+		if (std::abs(quantity) > 1e-6) {
+			LoseLevel(priceHash);
+			UpdateBandExhausted();
+		}
+		return;
+	}
+
+	const bool remove = std::abs(quantity) <= 1e-6;
+	OrdersMap* orders = &orders_;
+	if (orders_.find(priceHash) == orders_.end()) {
+		orders = &reserve_;
+		if (reserve_.find(priceHash) == reserve_.end()) {
+			orders = nullptr;
+		}
+	}
+
+	if (orders) {
+		if (remove) {
+			orders->erase(priceHash);
+		}
+		else {
+			orders->insert_or_assign(priceHash, quantity);
+		}
+	}
+	else if (!remove) {
+		// New level goes to the band if it is better than all reserve levels,
+		// band limits are applied by RebalanceBand
+		if (reserve_.empty() || IsBetter(priceHash, GetBest(reserve_)->first)) {
+			orders_.insert_or_assign(priceHash, quantity);
+		}
+		else {
+			reserve_.insert_or_assign(priceHash, quantity);
+		}
+	}
+
+	RebalanceBand();
+}
+
+void Orders::RebalanceBand()
+{
+	// Demote the worst levels that are outside the band, the touch always stays in the band
+	while (orders_.size() > 1 &&
+	       ((depthBand_.maxLevels && orders_.size() > depthBand_.maxLevels) ||
+	        (depthBand_.maxDeviation > 0.0 &&
+	         GetDistanceFromTouch(GetWorst(orders_)->first) > depthBand_.maxDeviation)))
+	{
+		const Order worst = *GetWorst(orders_);
+		orders_.erase(worst.first);
+		reserve_.insert_or_assign(worst.first, worst.second);
+		++bandStatistics_.demotedLevels;
+	}
+
+	// Re-admit the best reserve levels that are inside the band now
+	while (!reserve_.empty() &&
+	       (!depthBand_.maxLevels || orders_.size() < depthBand_.maxLevels) &&
+	       (orders_.empty() || depthBand_.maxDeviation <= 0.0 ||
+	        GetDistanceFromTouch(GetBest(reserve_)->first) <= depthBand_.maxDeviation))
+	{
+		const Order best = *GetBest(reserve_);
+		reserve_.erase(best.first);
+		orders_.insert_or_assign(best.first, best.second);
+		++bandStatistics_.readmittedLevels;
+	}
+
+	// Evict the worst reserve levels that are outside the reserve limits
+	while (!reserve_.empty() &&
+	       ((depthBand_.maxLevels && reserve_.size() > depthBand_.maxLevels) ||
+	        (depthBand_.maxDeviation > 0.0 &&
+	         GetDistanceFromTouch(GetWorst(reserve_)->first) > 2.0 * depthBand_.maxDeviation)))
+	{
+		LoseLevel(GetWorst(reserve_)->first);
+		reserve_.erase(GetWorst(reserve_)->first);
+		++bandStatistics_.evictedLevels;
+	}
+
+	UpdateBandExhausted();
+}
+
+void Orders::LoseLevel(const size_t priceHash)
+{
+	if (!levelsLost_ || IsBetter(priceHash, bestLostPriceHash_)) {
+		bestLostPriceHash_ = priceHash;
+	}
+	levelsLost_ = true;
+}
+
+void Orders::UpdateBandExhausted()
+{
+	// All levels better than the best lost one are tracked exactly,
+	// so the band is right unless the best lost level would be inside it
+	bool exhausted = false;
+	if (levelsLost_) {
+		exhausted = orders_.empty() ||
+		            ((!depthBand_.maxLevels || orders_.size() < depthBand_.maxLevels ||
+		              IsBetter(bestLostPriceHash_, GetWorst(orders_)->first)) &&
+		             (depthBand_.maxDeviation <= 0.0 ||
+		              GetDistanceFromTouch(bestLostPriceHash_) <= depthBand_.maxDeviation));
+	}
+
+	if (exhausted && !bandExhausted_) {
+		++bandStatistics_.exhaustedBands;
+	}
+	bandExhausted_ = exhausted;
+}
+
+bool Orders::IsBetter(const size_t priceHash, const size_t otherPriceHash) const
+{
+	return orderType_ == OrderType::BID ? priceHash > otherPriceHash : priceHash < otherPriceHash;
+}
+
+double Orders::GetDistanceFromTouch(const size_t priceHash) const
+{
+	// Distance is positive for levels that are worse than the touch
+	const double touch = static_cast<double>(GetBestPriceCents());
+	const double distance = orderType_ == OrderType::BID ? touch - priceHash : priceHash - touch;
+	return distance / touch;
+}
+
+Orders::OrdersMap::const_iterator Orders::GetBest(const OrdersMap& orders) const
+{
+	return orderType_ == OrderType::BID ? std::prev(orders.end()) : orders.begin();
+}
+
+Orders::OrdersMap::const_iterator Orders::GetWorst(const OrdersMap& orders) const
+{
+	return orderType_ == OrderType::BID ? orders.begin() : std::prev(orders.end());
+}
+
 double Orders::GetPriceHashMultiplier()
 {
 	return priceHashMultiplier;
@@ -110,3 +270,13 @@ size_t Orders::GetPriceCents(const double price)
 {
 	return std::llround(priceHashMultiplier * price);
 }
+
+DepthBandStatistics& DepthBandStatistics::operator+=(const DepthBandStatistics& other)
+{
+	droppedUpdates += other.droppedUpdates;
+	demotedLevels += other.demotedLevels;
+	readmittedLevels += other.readmittedLevels;
+	evictedLevels += other.evictedLevels;
+	exhaustedBands += other.exhaustedBands;
+	return *this;
+}
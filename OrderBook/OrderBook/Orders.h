@@ -1,5 +1,5 @@
 #pragma once
-#include <map>
+#include "OrderLevels.h"
 
 enum class OrderType
 {
@@ -10,12 +10,58 @@ enum class OrderType
 // first - price in cents, second - quantity
 using Order = std::pair<size_t, double>;
 
+/**
+ * @struct DepthBand
+ * @brief Limits levels of one side that are tracked by Orders to a band around the touch (best price).
+ * Zero limit is not applied, so by default all levels are tracked.
+ */
+struct DepthBand
+{
+	// Max number of levels
+	size_t maxLevels = 0;
+	// Max distance from the touch as a fraction of the touch price, e.g. 0.01 = 1%
+	double maxDeviation = 0.0;
+
+	bool Enabled() const { return maxLevels || maxDeviation > 0.0; }
+};
+
+/**
+ * @struct DepthBandStatistics
+ * @brief Counters of levels moved across the band boundaries
+ */
+struct DepthBandStatistics
+{
+	// Updates of levels outside both the band and the reserve, dropped without being stored
+	size_t droppedUpdates = 0;
+	// Levels moved from the band to the reserve
+	size_t demotedLevels = 0;
+	// Levels moved from the reserve back to the band as the touch moved
+	size_t readmittedLevels = 0;
+	// Levels removed from the reserve because it was full or they moved too far from the touch
+	size_t evictedLevels = 0;
+	// Times the band of a side was exhausted: a level dropped or evicted since the last sync shot
+	// would be inside the band, so the best price may be wrong, see Orders::IsBandExhausted
+	size_t exhaustedBands = 0;
+
+	DepthBandStatistics& operator+=(const DepthBandStatistics& other);
+};
+
 /**
  * @class Orders
  * @brief Implements logic of storage of orders of certain type.
- * Orders are stored inside std::map container with key = order price in cents and value = quantity.
+ * Orders are stored inside OrderLevels container with key = order price in cents and value = quantity.
  * Class provides const iterators for iterating over orders.
+ * Level storage is copy-on-write, so a copy of Orders is cheap: it shares all levels with the original
+ * and stays unchanged while the original is modified.
  * Modification of orders is available via Clear and HandleOrderUpdate method.
+ *
+ * If the depth band is set, only levels inside the band are stored in the map and iterated over.
+ * Levels just outside the band are kept in the reserve of the same size (K levels or 2 * X from the touch),
+ * so they can be re-admitted when the touch moves. Updates of levels outside the reserve are dropped in O(1).
+ * Levels that are dropped or evicted are lost until the next Clear (sync shot). A sweep deeper than the band
+ * and the reserve empties both of them or moves the touch to the lost levels, so the best price and features
+ * can be wrong until the next sync shot. The side is marked as exhausted while the best lost level
+ * would be inside the band, see IsBandExhausted.
  */
 class Orders
 {
@@ -43,9 +89,32 @@ public:
 	 */
 	size_t Size() const;
 
+	/**
+	 * @brief Sets the depth band, must be called before any order is added
+	 *
+	 * @param depthBand    Band limits, default value disables the band
+	 */
+	void SetDepthBand(const DepthBand& depthBand);
+
+	/**
+	 * @return             Depth band limits
+	 */
+	const DepthBand& GetDepthBand() const { return depthBand_; }
+
+	/**
+	 * @return             True if some level dropped or evicted since the last Clear would be inside the band now,
+	 *                     so the best price and the band levels may be wrong
+	 */
+	bool IsBandExhausted() const { return bandExhausted_; }
+
+	/**
+	 * @return             Counters of levels moved across the band boundaries
+	 */
+	const DepthBandStatistics& GetDepthBandStatistics() const { return bandStatistics_; }
+
 public:
 	// key - price in cents, value - quantity
-	using OrdersMap = std::map<std::size_t, double>;
+	using OrdersMap = OrderLevels;
 	using const_iterator = OrdersMap::const_iterator;
 	using const_reverse_iterator = OrdersMap::const_reverse_iterator;
 
@@ -108,9 +177,30 @@ public:
 	 */
 	static size_t GetPriceCents(const double price);
 
+private:
+	void HandleBandedOrderUpdate(const size_t priceHash, const double quantity);
+	void RebalanceBand();
+	void LoseLevel(const size_t priceHash);
+	void UpdateBandExhausted();
+	void RemoveCrossingOrders(OrdersMap& orders, const Orders& otherSide) const;
+
+	bool IsBetter(const size_t priceHash, const size_t otherPriceHash) const;
+	double GetDistanceFromTouch(const size_t priceHash) const;
+	OrdersMap::const_iterator GetBest(const OrdersMap& orders) const;
+	OrdersMap::const_iterator GetWorst(const OrdersMap& orders) const;
+
 private:
 	const OrderType orderType_;
 	OrdersMap orders_;
 	static constexpr double priceHashMultiplier = 100.0;
+
+	DepthBand depthBand_;
+	// Levels outside the band, all of them are worse than levels inside the band
+	OrdersMap reserve_;
+	DepthBandStatistics bandStatistics_;
+	// Some levels were dropped or evicted since the last Clear, the best of them
+	bool levelsLost_ = false;
+	size_t bestLostPriceHash_ = 0;
+	bool bandExhausted_ = false;
 };
 
@@ -0,0 +1,144 @@
+#include "ResultsWriter.h"
+#include <algorithm>
+#include <charconv>
+
+ordwriter::BufferedFileWriter::BufferedFileWriter(const std::filesystem::path& path, const bool asyncFlush,
+                                                  const size_t bufferSize) :
+	file_(path, std::ios::binary | std::ios::trunc),
+	buffer_(bufferSize),
+	asyncFlush_(asyncFlush)
+{
+	if (asyncFlush_ && file_.is_open()) {
+		backBuffer_.resize(bufferSize);
+		thread_ = std::thread(&BufferedFileWriter::BackgroundFlush, this);
+	}
+}
+
+ordwriter::BufferedFileWriter::~BufferedFileWriter()
+{
+	Close();
+}
+
+void ordwriter::BufferedFileWriter::Write(const char* data, size_t size)
+{
+	while (size) {
+		if (used_ == buffer_.size()) {
+			Flush();
+		}
+		const size_t chunk = std::min(size, buffer_.size() - used_);
+		std::copy_n(data, chunk, buffer_.data() + used_);
+		used_ += chunk;
+		data += chunk;
+		size -= chunk;
+	}
+}
+
+void ordwriter::BufferedFileWriter::Flush()
+{
+	if (!used_) {
+		return;
+	}
+
+	if (!thread_.joinable()) {
+		file_.write(buffer_.data(), used_);
+		used_ = 0;
+		return;
+	}
+
+	// Wait until the background thread finishes writing the previous buffer
+	// and hand the current one over to it
+	std::unique_lock<std::mutex> lock(mutex_);
+	condition_.wait(lock, [this] { return !backPending_; });
+	buffer_.swap(backBuffer_);
+	backUsed_ = used_;
+	backPending_ = true;
+	used_ = 0;
+	lock.unlock();
+	condition_.notify_all();
+}
+
+void ordwriter::BufferedFileWriter::WriteAt(const std::streamoff offset, const char* data, const size_t size)
+{
+	Flush();
+	WaitForBackgroundFlush();
+
+	file_.seekp(offset);
+	file_.write(data, size);
+	file_.seekp(0, std::ios::end);
+}
+
+void ordwriter::BufferedFileWriter::Close()
+{
+	if (!file_.is_open()) {
+		return;
+	}
+
+	Flush();
+	if (thread_.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stop_ = true;
+		}
+		condition_.notify_all();
+		thread_.join();
+	}
+	file_.close();
+}
+
+void ordwriter::BufferedFileWriter::WaitForBackgroundFlush()
+{
+	if (!thread_.joinable()) {
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	condition_.wait(lock, [this] { return !backPending_; });
+}
+
+void ordwriter::BufferedFileWriter::BackgroundFlush()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (true)
+	{
+		condition_.wait(lock, [this] { return backPending_ || stop_; });
+		if (backPending_) {
+			// The back buffer belongs to this thread until backPending_ is reset
+			lock.unlock();
+			file_.write(backBuffer_.data(), backUsed_);
+			lock.lock();
+			backPending_ = false;
+			condition_.notify_all();
+		}
+		else if (stop_) {
+			break;
+		}
+	}
+}
+
+ordwriter::ResultsWriter::ResultsWriter(const std::filesystem::path& path, const bool asyncFlush) :
+	file_(path, asyncFlush)
+{}
+
+void ordwriter::ResultsWriter::Write(const std::string_view text)
+{
+	file_.Write(text.data(), text.size());
+}
+
+void ordwriter::ResultsWriter::Write(const size_t value)
+{
+	char* first = file_.Reserve(maxNumberSize);
+	const auto result = std::to_chars(first, first + maxNumberSize, value);
+	file_.Commit(result.ptr - first);
+}
+
+void ordwriter::ResultsWriter::Write(const double value)
+{
+	char* first = file_.Reserve(maxNumberSize);
+	const auto result = std::to_chars(first, first + maxNumberSize, value);
+	file_.Commit(result.ptr - first);
+}
+
+void ordwriter::ResultsWriter::Close()
+{
+	file_.Close();
+}
@@ -0,0 +1,165 @@
+#pragma once
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace ordwriter
+{
+/**
+ * @class BufferedFileWriter
+ * @brief Writes bytes to a binary file through a large reusable buffer.
+ * The buffer is written to the file only when it is full or on Flush and Close.
+ * If async flush is enabled, the writer has two buffers: while one of them is written
+ * to the file by the background thread, the other one is being filled, so formatting overlaps disk writes.
+ */
+class BufferedFileWriter
+{
+public:
+	static constexpr size_t defaultBufferSize = 1 << 22;
+
+	/**
+	 * @brief Constructor.
+	 * Opens the file, if it exists it is truncated
+	 *
+	 * @param path         Path to the file
+	 * @param asyncFlush   If true, buffers are written to the file by the background thread
+	 * @param bufferSize   Size of each buffer in bytes
+	 */
+	BufferedFileWriter(const std::filesystem::path& path, const bool asyncFlush = false,
+	                   const size_t bufferSize = defaultBufferSize);
+
+	/**
+	 * @brief Destructor.
+	 * Writes buffered data and closes the file
+	 */
+	~BufferedFileWriter();
+
+	BufferedFileWriter(const BufferedFileWriter&) = delete;
+	BufferedFileWriter& operator=(const BufferedFileWriter&) = delete;
+
+	/**
+	 * @return             True if the file was opened successfully
+	 */
+	bool IsOpen() const { return file_.is_open(); }
+
+	/**
+	 * @brief Returns pointer to at least size free bytes in the buffer.
+	 * Written bytes must be committed using Commit method
+	 *
+	 * @param size         Number of bytes, must not exceed the buffer size
+	 */
+	char* Reserve(const size_t size)
+	{
+		if (used_ + size > buffer_.size()) {
+			Flush();
+		}
+		return buffer_.data() + used_;
+	}
+
+	/**
+	 * @brief Commits size bytes written to the memory returned by Reserve
+	 */
+	void Commit(const size_t size) { used_ += size; }
+
+	/**
+	 * @brief Appends data of arbitrary size to the buffer
+	 */
+	void Write(const char* data, size_t size);
+
+	/**
+	 * @brief Passes buffered data to the file or to the background thread
+	 */
+	void Flush();
+
+	/**
+	 * @brief Overwrites already written bytes at given offset from the beginning of the file.
+	 * Waits until all buffered data is written
+	 */
+	void WriteAt(const std::streamoff offset, const char* data, const size_t size);
+
+	/**
+	 * @brief Writes buffered data, stops the background thread and closes the file
+	 */
+	void Close();
+
+private:
+	void WaitForBackgroundFlush();
+	void BackgroundFlush();
+
+private:
+	std::ofstream file_;
+	std::vector<char> buffer_;
+	size_t used_ = 0;
+
+	// Members used only if async flush is enabled
+	const bool asyncFlush_;
+	std::vector<char> backBuffer_;
+	size_t backUsed_ = 0;
+	bool backPending_ = false;
+	bool stop_ = false;
+	std::mutex mutex_;
+	std::condition_variable condition_;
+	std::thread thread_;
+};
+
+/**
+ * @class ResultsWriter
+ * @brief Writes comma separated results to the file.
+ * Numbers are formatted using std::to_chars, so doubles are written in the shortest form
+ * that is parsed back to the same value and the output is the same for every run.
+ * Rows are not flushed, data is written to the file only when the buffer is full.
+ * Rows end with CRLF on Windows and with LF on other platforms, as in text mode files.
+ */
+class ResultsWriter
+{
+public:
+	/**
+	 * @brief Constructor.
+	 * Opens the file, if it exists it is truncated
+	 *
+	 * @param path         Path to the resulting file
+	 * @param asyncFlush   If true, buffers are written to the file by the background thread
+	 */
+	ResultsWriter(const std::filesystem::path& path, const bool asyncFlush = false);
+
+	/**
+	 * @return             True if the file was opened successfully
+	 */
+	bool IsOpen() const { return file_.IsOpen(); }
+
+	void Write(const std::string_view text);
+	void Write(const size_t value);
+	void Write(const double value);
+
+	/**
+	 * @brief Writes the column separator
+	 */
+	void WriteSeparator() { *file_.Reserve(1) = ','; file_.Commit(1); }
+
+	/**
+	 * @brief Finishes the current row.
+	 * The file is binary, so the line break of the platform text files is written explicitly
+	 */
+	void EndRow() { Write(rowEnd); }
+
+	/**
+	 * @brief Writes buffered data and closes the file
+	 */
+	void Close();
+
+#ifdef _WIN32
+	static constexpr std::string_view rowEnd = "\r\n";
+#else
+	static constexpr std::string_view rowEnd = "\n";
+#endif
+
+private:
+	// Enough for any double or size_t in the shortest form
+	static constexpr size_t maxNumberSize = 32;
+	BufferedFileWriter file_;
+};
+}
@@ -1,28 +1,179 @@
+#include "Benchmarks.h"
 #include "OrderProcessingTools.h"
+#include <charconv>
 #include <chrono>
+#include <cmath>
 #include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+// Parses the whole value of the option, e.g. "5" of "--depth=5".
+// Returns false if the value is empty, is not a number or has extra characters, negative counts are rejected
+template <typename T>
+bool ParseOptionValue(const std::string& value, T& result)
+{
+	const char* end = value.data() + value.size();
+	const auto [parsed, error] = std::from_chars(value.data(), end, result);
+	return !value.empty() && error == std::errc() && parsed == end;
+}
+
+// Parses the option that has the default value, e.g. "--benchmark-engine" or "--benchmark-engine=1000".
+// Returns false if the value is passed but it is not a positive number
+bool ParseOptionalCount(const std::string& arg, const std::string& name, const size_t defaultValue, size_t& result)
+{
+	if (arg == name) {
+		result = defaultValue;
+		return true;
+	}
+	return ParseOptionValue(arg.substr(name.size() + 1), result) && result > 0;
+}
+}
 
 int main(int argc, char** argv)
 {
+	// Arguments starting with "--" are options, the rest are positional arguments
+	std::vector<char*> positional;
+	size_t ladderDepth = 0;
+	std::string featureSetName = "all";
+	bool asyncFlush = false;
+	DepthBand depthBand;
+	size_t benchmarkRows = 0;
+	size_t benchmarkEvents = 0;
+	size_t benchmarkWorkersEvents = 0;
+	size_t featureWorkers = 0;
+	std::string firstDay, lastDay;
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		bool validValue = true;
+		if (arg.rfind("--ladder=", 0) == 0) {
+			validValue = ParseOptionValue(arg.substr(9), ladderDepth);
+		}
+		else if (arg.rfind("--features=", 0) == 0) {
+			featureSetName = arg.substr(11);
+		}
+		else if (arg.rfind("--depth=", 0) == 0) {
+			validValue = ParseOptionValue(arg.substr(8), depthBand.maxLevels);
+		}
+		else if (arg.rfind("--band=", 0) == 0) {
+			// Band is passed in percents
+			double percents = 0.0;
+			validValue = ParseOptionValue(arg.substr(7), percents) && std::isfinite(percents) && percents >= 0.0;
+			depthBand.maxDeviation = percents / 100.0;
+		}
+		else if (arg.rfind("--days=", 0) == 0) {
+			// Range of days is passed as YYYYMMDD-YYYYMMDD or as one day YYYYMMDD
+			const std::string days = arg.substr(7);
+			const size_t separator = days.find('-');
+			firstDay = days.substr(0, separator);
+			lastDay = separator == std::string::npos ? firstDay : days.substr(separator + 1);
+			validValue = ordfiles::IsDay(firstDay) && ordfiles::IsDay(lastDay) && firstDay <= lastDay;
+		}
+		else if (arg.rfind("--feature-workers=", 0) == 0) {
+			validValue = ParseOptionValue(arg.substr(18), featureWorkers);
+		}
+		else if (arg == "--async-flush") {
+			asyncFlush = true;
+		}
+		else if (arg == "--benchmark-output" || arg.rfind("--benchmark-output=", 0) == 0) {
+			validValue = ParseOptionalCount(arg, "--benchmark-output", 1000000, benchmarkRows);
+		}
+		else if (arg == "--benchmark-engine" || arg.rfind("--benchmark-engine=", 0) == 0) {
+			validValue = ParseOptionalCount(arg, "--benchmark-engine", 10000000, benchmarkEvents);
+		}
+		else if (arg == "--benchmark-workers" || arg.rfind("--benchmark-workers=", 0) == 0) {
+			validValue = ParseOptionalCount(arg, "--benchmark-workers", 10000000, benchmarkWorkersEvents);
+		}
+		else if (arg.rfind("--", 0) == 0) {
+			std::cout << "Unknown option: " << arg;
+			return -1;
+		}
+		else {
+			positional.push_back(argv[i]);
+		}
+
+		if (!validValue) {
+			std::cout << "Invalid value of option: " << arg;
+			return -1;
+		}
+	}
+	argc = static_cast<int>(positional.size()) + 1;
+	positional.insert(positional.begin(), argv[0]);
+	argv = positional.data();
+
+	// --benchmark-output[=rows], --benchmark-engine[=events] and --benchmark-workers[=events]
+	// only measure performance
+	if (benchmarkRows || benchmarkEvents || benchmarkWorkersEvents) {
+		if (benchmarkRows) {
+			ordbench::BenchmarkResultsOutput(std::filesystem::temp_directory_path(), benchmarkRows);
+		}
+		if (benchmarkEvents) {
+			ordbench::BenchmarkEngine(benchmarkEvents);
+		}
+		if (benchmarkWorkersEvents) {
+			ordbench::BenchmarkFeatureWorkers(benchmarkWorkersEvents);
+		}
+		return 0;
+	}
+
+	// --features=none disables features, otherwise it selects one of prebuilt feature sets
+	const ordbkfeatures::FeatureSetInfo* featureSet = nullptr;
+	if (featureSetName != "none") {
+		featureSet = ordbkfeatures::FindFeatureSet(featureSetName);
+		if (!featureSet) {
+			std::cout << "Unknown feature set: " << featureSetName << ". Available sets are: none";
+			for (const auto& set : ordbkfeatures::GetFeatureSets()) {
+				std::cout << ", " << set.name;
+			}
+			return -1;
+		}
+	}
+
 	if (argc < 3) {
-		std::cout << "Wrong number of arguments. Need to specify path to syncshots and updates files";
+		std::cout << "Wrong number of arguments. Need to specify path to syncshots and updates files"
+                     " or path to the data directory and instrument with --days option";
 		return -1;
 	}
 
 	std::ifstream syncShots, updates;
+	std::vector<ordfiles::DayFiles> days;
+	if (firstDay.empty()) {
+		// First argument is path to the sync shots file
+		syncShots.open(argv[1]);
+		if (!syncShots.is_open()) {
+			std::cout << "Could not open sync shots file: " << argv[1];
+			return -1;
+		}
 
-	// First argument is path to the sync shots file
-	syncShots.open(argv[1]);
-	if (!syncShots.is_open()) {
-		std::cout << "Could not open sync shots file: " << argv[1];
-		return -1;
+		// Second - is path to the updates file
+		updates.open(argv[2]);
+		if (!updates.is_open()) {
+			std::cout << "Could not open updates file: " << argv[2];
+			return -1;
+		}
 	}
+	else {
+		// With --days option first argument is path to the data directory and second - is the instrument
+		if (!std::filesystem::is_directory(argv[1])) {
+			std::cout << "Passed path to the data directory does not exist: " << argv[1];
+			return -1;
+		}
 
-	// Second - is path to the updates file
-	updates.open(argv[2]);
-	if (!updates.is_open()) {
-		std::cout << "Could not open updates file: " << argv[2];
-		return -1;
+		try {
+			days = ordfiles::FindDayFiles(argv[1], argv[2], firstDay, lastDay);
+		}
+		catch (const std::exception& e) {
+			std::cout << "Error while searching files: " << e.what();
+			return -1;
+		}
+
+		if (days.empty()) {
+			std::cout << "No files of " << argv[2] << " found for days " << firstDay << "-" << lastDay;
+			return -1;
+		}
 	}
 
 	// If third argument is specified, we treat it as path to resulting derictory
@@ -42,17 +193,49 @@ int main(int argc, char** argv)
 	}
 
 	resultPath /= "results.csv";
-	std::ofstream results;
-	results.open(resultPath);
+	ordwriter::ResultsWriter results(resultPath, asyncFlush);
+	if (!results.IsOpen()) {
+		std::cout << "Could not open results file: " << resultPath;
+		return -1;
+	}
+
+	// If --ladder=<depth> option is specified, top levels of the order book are written
+	// to the binary ladder.bin file next to the results file
+	std::unique_ptr<ordladder::LadderWriter> ladderWriter;
+	if (ladderDepth) {
+		const auto ladderPath = resultPath.parent_path() / "ladder.bin";
+		ladderWriter = std::make_unique<ordladder::LadderWriter>(ladderPath, ladderDepth, asyncFlush);
+		if (!ladderWriter->IsOpen()) {
+			std::cout << "Could not open ladder file: " << ladderPath;
+			return -1;
+		}
+	}
 
 	std::cout << "Started files processing" << std::endl;
 	try {
 		auto begin = std::chrono::steady_clock::now();
-		ordtools::ProcessSyncShotsAndUpdates(syncShots, updates, results, /* logFeatures = */ true);
+		DepthBandStatistics bandStatistics;
+		if (days.empty()) {
+			ordtools::ProcessSyncShotsAndUpdates(syncShots, updates, results, featureSet, ladderWriter.get(),
+                                                 depthBand, &bandStatistics, featureWorkers);
+		}
+		else {
+			std::cout << "Processing " << days.size() << " days from " << days.front().day
+                      << " to " << days.back().day << std::endl;
+			ordtools::ProcessDays(days, results, featureSet, ladderWriter.get(), depthBand, &bandStatistics,
+                                  featureWorkers);
+		}
 		auto end = std::chrono::steady_clock::now();
 		auto elapsed_s = std::chrono::duration_cast<std::chrono::microseconds>(end - begin);
 		std::cout << "Processing is finished, elapsed time is "
                   << elapsed_s.count() << " microseconds" << std::endl;
+		if (depthBand.Enabled()) {
+			std::cout << "Depth band statistics: dropped updates " << bandStatistics.droppedUpdates
+                      << ", demoted levels " << bandStatistics.demotedLevels
+                      << ", re-admitted levels " << bandStatistics.readmittedLevels
+                      << ", evicted levels " << bandStatistics.evictedLevels
+                      << ", exhausted bands " << bandStatistics.exhaustedBands << std::endl;
+		}
 	}
 	catch (const std::exception& e) {
 		std::cout << "Error while processing files: " << e.what() << std::endl;
@@ -60,6 +243,9 @@ int main(int argc, char** argv)
 
 	syncShots.close();
 	updates.close();
-	results.close();
+	results.Close();
+	if (ladderWriter) {
+		ladderWriter->Close();
+	}
 	return 0;
 }
\ No newline at end of file